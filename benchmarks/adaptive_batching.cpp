@@ -0,0 +1,177 @@
+// adaptive_batching: TAdaptiveBatcher under light and heavy load.
+//
+// Under light load, the writer sends a record every gap microseconds, and
+// the latency from write to read is what matters.  The adaptive batches
+// should collapse to minBatch, and the latency should be close to that of
+// publishing every record.  Under heavy load, the writer sends as fast as
+// it can, and throughput is what matters.  The batches should grow towards
+// maxBatch, and the throughput should be close to that of a fixed batch of
+// maxBatch.  Each regime is run with a fixed batch of 1, a fixed batch of
+// maxBatch, and the adaptive batch between them.
+//
+// Usage:
+//   adaptive_batching [records] [gap-us]
+//
+// The writer and reader should run on different cores for the numbers to
+// mean anything.
+
+#include <daugaard/adaptive_batching.hpp>
+#include <daugaard/cpu.hpp>
+#include <daugaard/ring_buffer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace DAUGAARD_RING_BUFFER_NAMESPACE;
+namespace detail = DAUGAARD_RING_BUFFER_NAMESPACE::rb::detail;
+
+constexpr std::size_t ringSize = std::size_t(1) << 16;
+constexpr std::size_t maxBatch = 64;
+
+struct Record
+{
+    std::uint64_t sent;
+    std::uint64_t sequence;
+};
+
+struct Result
+{
+    double recordsPerSecond;
+    double p50;
+    double p99;
+    std::size_t writeBatch;
+    std::size_t readBatch;
+    std::uint64_t stalls;
+};
+
+Result
+Run(AdaptiveBatchConfig const & config, std::size_t records, double gapUs)
+{
+    double const cyclesPerUs = detail::cycles_per_microsecond();
+    std::uint64_t const gap = static_cast<std::uint64_t>(gapUs * cyclesPerUs);
+
+    void * memory = ::operator new(
+        ringSize,
+        std::align_val_t(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE));
+    RingBuffer ring;
+    ring.Initialize(memory, ringSize);
+    TAdaptiveBatcher<RingBuffer> batcher(ring, config);
+    std::vector<std::uint64_t> latencies(records);
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread writer([&] {
+        std::uint64_t next = detail::read_cycle_counter();
+        for (std::size_t i = 0; i < records; i++) {
+            if (gap != 0) {
+                next += gap;
+                while (detail::read_cycle_counter() < next) {
+                    detail::cpu_relax();
+                }
+            }
+            batcher.Write(Record{detail::read_cycle_counter(), i});
+            batcher.FinishWriteRecord();
+        }
+        batcher.FlushWrite();
+    });
+
+    for (std::size_t i = 0; i < records; i++) {
+        Record const & record = batcher.Read<Record>();
+        if (record.sequence != i) {
+            std::fprintf(stderr, "record %zu out of order\n", i);
+            std::exit(1);
+        }
+        latencies[i] = detail::read_cycle_counter() - record.sent;
+        batcher.FinishReadRecord();
+    }
+    batcher.FlushRead();
+    writer.join();
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    Result result;
+    result.recordsPerSecond = double(records) / seconds;
+    std::size_t p50 = records / 2;
+    std::size_t p99 = records - records / 100 - 1;
+    std::nth_element(
+        latencies.begin(),
+        latencies.begin() + p50,
+        latencies.end());
+    result.p50 = double(latencies[p50]) / cyclesPerUs;
+    std::nth_element(
+        latencies.begin(),
+        latencies.begin() + p99,
+        latencies.end());
+    result.p99 = double(latencies[p99]) / cyclesPerUs;
+    result.writeBatch = batcher.WriteBatchSize();
+    result.readBatch = batcher.ReadBatchSize();
+    result.stalls = batcher.Stalls();
+
+    ::operator delete(
+        memory,
+        std::align_val_t(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE));
+    return result;
+}
+
+void
+Report(char const * regime, char const * name, Result const & result)
+{
+    std::printf(
+        "%-6s %-9s %12.0f %10.2f %10.2f %6zu %6zu %8llu\n",
+        regime,
+        name,
+        result.recordsPerSecond,
+        result.p50,
+        result.p99,
+        result.writeBatch,
+        result.readBatch,
+        static_cast<unsigned long long>(result.stalls));
+}
+
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+    std::size_t records = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 0;
+    double gapUs = argc > 2 ? std::strtod(argv[2], nullptr) : 20.0;
+    if (records == 0) {
+        records = 1000000;
+    }
+
+    AdaptiveBatchConfig fixedOne;
+    fixedOne.minBatch = fixedOne.maxBatch = 1;
+    AdaptiveBatchConfig fixedMax;
+    fixedMax.minBatch = fixedMax.maxBatch = maxBatch;
+    AdaptiveBatchConfig adaptive;
+    adaptive.minBatch = 1;
+    adaptive.maxBatch = maxBatch;
+
+    std::printf(
+        "%-6s %-9s %12s %10s %10s %6s %6s %8s\n",
+        "load",
+        "batch",
+        "records/s",
+        "p50 us",
+        "p99 us",
+        "write",
+        "read",
+        "stalls");
+
+    // Light load sends fewer records, since each one takes gapUs.
+    std::size_t lightRecords = std::max<std::size_t>(records / 100, 1000);
+    Report("light", "1", Run(fixedOne, lightRecords, gapUs));
+    Report("light", "64", Run(fixedMax, lightRecords, gapUs));
+    Report("light", "adaptive", Run(adaptive, lightRecords, gapUs));
+    Report("heavy", "1", Run(fixedOne, records, 0));
+    Report("heavy", "64", Run(fixedMax, records, 0));
+    Report("heavy", "adaptive", Run(adaptive, records, 0));
+    return 0;
+}
@@ -0,0 +1,230 @@
+#ifndef DAUGAARD_RING_BUFFER_ADAPTIVE_BATCHING_5ec58bedf3244b90b4e4ab35751626db
+#define DAUGAARD_RING_BUFFER_ADAPTIVE_BATCHING_5ec58bedf3244b90b4e4ab35751626db
+
+// Publishing after every record gives the lowest latency, and publishing
+// after many gives the highest throughput.  TAdaptiveBatcher picks the
+// number of records per FinishWrite and per FinishRead at run time, with
+// additive increase and multiplicative decrease rules.
+//
+// The writer batches more while the reader lags behind by more than
+// highLag bytes, and halves its batch as soon as the reader catches up.
+// The reader releases more records at a time while the writer has room,
+// and halves its batch whenever the writer has had to wait for space.
+// Neither batch grows past maxBatch records, which bounds the latency that
+// batching adds while records keep coming.  The bound is a count of
+// records, not a time: a writer that pauses with a partial batch must call
+// FlushWrite, or its records wait until the next ones fill the batch.
+//
+// Both sides publish what they have before waiting on the other, so
+// batching can not deadlock.  A reader that goes idle should likewise call
+// FlushRead.
+
+#include "ring_buffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+struct AdaptiveBatchConfig
+{
+    std::size_t minBatch = 1;
+    std::size_t maxBatch = 64;
+
+    // Added to a batch size under load.
+    std::size_t increase = 1;
+
+    // Reader lag, in bytes, above which the writer batches more.  Zero means
+    // a quarter of the buffer.
+    std::size_t highLag = 0;
+};
+
+// A batch size that grows additively and shrinks multiplicatively.
+class AimdBatchSize
+{
+public:
+    explicit AimdBatchSize(AdaptiveBatchConfig const & config)
+    : m_Min(std::max<std::size_t>(config.minBatch, 1))
+    , m_Max(std::max(config.maxBatch, m_Min))
+    , m_Increase(config.increase)
+    , m_Value(m_Min)
+    { }
+
+    std::size_t Value() const { return m_Value; }
+
+    void Increase() { m_Value = std::min(m_Value + m_Increase, m_Max); }
+    void Decrease() { m_Value = std::max(m_Value / 2, m_Min); }
+
+private:
+    std::size_t m_Min;
+    std::size_t m_Max;
+    std::size_t m_Increase;
+    std::size_t m_Value;
+};
+
+template <typename RingT>
+class TAdaptiveBatcher
+{
+public:
+    // Call after the ring has been initialized.
+    explicit TAdaptiveBatcher(
+        RingT & ring,
+        AdaptiveBatchConfig const & config = AdaptiveBatchConfig())
+    : m_Ring(ring)
+    , m_Writer{
+          AimdBatchSize(config),
+          config.highLag ? config.highLag : ring.Capacity() / 4}
+    , m_Reader{AimdBatchSize(config)}
+    {
+        m_Stalls.count.store(0, std::memory_order_relaxed);
+    }
+
+    TAdaptiveBatcher(TAdaptiveBatcher const &) = delete;
+    TAdaptiveBatcher & operator = (TAdaptiveBatcher const &) = delete;
+
+    // Writer: allocate buffer space, publishing first if the reader has to
+    // make room.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareWrite(
+        size_t size,
+        size_t alignment)
+    {
+        if (m_Ring.WriteWouldWait(size, alignment)) {
+            m_Stalls.count.store(
+                m_Stalls.count.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+            Publish();
+        }
+        return m_Ring.PrepareWrite(size, alignment);
+    }
+
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void Write(T const & value)
+    {
+        void * dest = PrepareWrite(sizeof(T), alignof(T));
+        new (dest) T(value);
+    }
+
+    // Writer: count a complete record, and publish if the batch is full.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishWriteRecord()
+    {
+        if (++m_Writer.pending >= m_Writer.batch.Value()) {
+            Publish();
+        }
+    }
+
+    // Writer: publish everything written so far.
+    void FlushWrite()
+    {
+        if (m_Writer.pending != 0) {
+            Publish();
+        }
+    }
+
+    // Reader: get read pointer, first releasing what has been read if the
+    // writer has to publish more.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareRead(
+        size_t size,
+        size_t alignment)
+    {
+        if (m_Reader.pending != 0 && m_Ring.ReadWouldWait(size, alignment)) {
+            Release();
+        }
+        return m_Ring.PrepareRead(size, alignment);
+    }
+
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE const T & Read()
+    {
+        return *static_cast<T *>(PrepareRead(sizeof(T), alignof(T)));
+    }
+
+    // Reader: count a consumed record, and release if the batch is full.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishReadRecord()
+    {
+        if (++m_Reader.pending >= m_Reader.batch.Value()) {
+            Release();
+        }
+    }
+
+    // Reader: release everything read so far.
+    void FlushRead()
+    {
+        if (m_Reader.pending != 0) {
+            Release();
+        }
+    }
+
+    std::size_t WriteBatchSize() const { return m_Writer.batch.Value(); }
+    std::size_t ReadBatchSize() const { return m_Reader.batch.Value(); }
+
+    // Number of times the writer has had to wait for space.
+    std::uint64_t Stalls() const
+    {
+        return m_Stalls.count.load(std::memory_order_relaxed);
+    }
+
+private:
+    void Publish()
+    {
+        m_Ring.FinishWrite();
+        m_Writer.pending = 0;
+        std::size_t lag =
+            m_Ring.WritePosition() - m_Ring.PublishedReadPosition();
+        if (lag > m_Writer.highLag) {
+            m_Writer.batch.Increase();
+        } else {
+            m_Writer.batch.Decrease();
+        }
+    }
+
+    void Release()
+    {
+        m_Ring.FinishRead();
+        m_Reader.pending = 0;
+        std::uint64_t stalls = m_Stalls.count.load(std::memory_order_relaxed);
+        if (stalls != m_Reader.stalls) {
+            m_Reader.stalls = stalls;
+            m_Reader.batch.Decrease();
+        } else {
+            m_Reader.batch.Increase();
+        }
+    }
+
+    RingT & m_Ring;
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) WriterState
+    {
+        AimdBatchSize batch;
+        std::size_t highLag;
+        std::size_t pending = 0;
+    };
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) ReaderState
+    {
+        AimdBatchSize batch;
+        std::size_t pending = 0;
+        std::uint64_t stalls = 0;
+    };
+
+    // Written by the writer, and read by the reader when it releases.
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) StallState
+    {
+        std::atomic<std::uint64_t> count;
+    };
+
+    WriterState m_Writer;
+    ReaderState m_Reader;
+    StallState m_Stalls;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::AdaptiveBatchConfig;
+using rb::AimdBatchSize;
+using rb::TAdaptiveBatcher;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_ADAPTIVE_BATCHING_5ec58bedf3244b90b4e4ab35751626db
@@ -0,0 +1,140 @@
+#ifndef DAUGAARD_RING_BUFFER_BOUNDED_WRITE_0f5e2ed521414bdab551e0e91180ec4a
+#define DAUGAARD_RING_BUFFER_BOUNDED_WRITE_0f5e2ed521414bdab551e0e91180ec4a
+
+// Writes that wait for the reader for a bounded time, and are dropped if
+// there is still no space.  TBoundedWriter waits at most config.spins times,
+// and then, if config.time is not zero, keeps trying until that much time
+// has passed.  A dropped record is counted, and the reader can read the
+// count at any time to report the gap.
+//
+// Each record must be written with a single PrepareWrite, so that a record
+// is either written whole or dropped whole.
+
+#include "cpu.hpp"
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+struct BoundedWriteConfig
+{
+    // Times to wait for the reader before checking the time.
+    std::size_t spins = 1000;
+
+    // Further time to keep trying for, after the spins.
+    std::chrono::nanoseconds time = std::chrono::nanoseconds(0);
+};
+
+template <typename RingT>
+class TBoundedWriter
+{
+public:
+    explicit TBoundedWriter(
+        RingT & ring,
+        BoundedWriteConfig const & config = BoundedWriteConfig())
+    : m_Ring(ring)
+    , m_Writer{config.spins, ToCycles(config.time)}
+    {
+        m_Drops.count.store(0, std::memory_order_relaxed);
+    }
+
+    TBoundedWriter(TBoundedWriter const &) = delete;
+    TBoundedWriter & operator = (TBoundedWriter const &) = delete;
+
+    // Writer: allocate buffer space for a record, or count the record as
+    // dropped and return nullptr if the reader does not make room in time.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareWrite(
+        size_t size,
+        size_t alignment)
+    {
+        void * dest = m_Ring.TryPrepareWrite(size, alignment, m_Writer.spins);
+        if (dest == nullptr) {
+            dest = WaitForSpace(size, alignment);
+        }
+        return dest;
+    }
+
+    // Writer: returns false if the record was dropped.
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE bool Write(T const & value)
+    {
+        void * dest = PrepareWrite(sizeof(T), alignof(T));
+        if (dest == nullptr) {
+            return false;
+        }
+        new (dest) T(value);
+        return true;
+    }
+
+    // Writer: publish written records.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishWrite()
+    {
+        m_Ring.FinishWrite();
+    }
+
+    // Any thread: number of records dropped so far.
+    std::uint64_t Drops() const
+    {
+        return m_Drops.count.load(std::memory_order_relaxed);
+    }
+
+private:
+    static std::uint64_t ToCycles(std::chrono::nanoseconds time)
+    {
+        if (time.count() <= 0) {
+            return 0;
+        }
+        return static_cast<std::uint64_t>(
+            double(time.count()) / 1000.0 * detail::cycles_per_microsecond());
+    }
+
+    void * WaitForSpace(size_t size, size_t alignment)
+    {
+        if (m_Writer.cycles != 0) {
+            std::uint64_t deadline =
+                detail::read_cycle_counter() + m_Writer.cycles;
+            do {
+                void * dest =
+                    m_Ring.TryPrepareWrite(size, alignment, m_Writer.spins);
+                if (dest != nullptr) {
+                    return dest;
+                }
+            } while (detail::read_cycle_counter() < deadline);
+        }
+        // Only the writer writes the count, so no read-modify-write.
+        m_Drops.count.store(
+            m_Drops.count.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    RingT & m_Ring;
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) WriterState
+    {
+        std::size_t spins;
+        std::uint64_t cycles;
+    };
+
+    // Written by the writer, and read by the reader.
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) DropState
+    {
+        std::atomic<std::uint64_t> count;
+    };
+
+    WriterState m_Writer;
+    DropState m_Drops;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::BoundedWriteConfig;
+using rb::TBoundedWriter;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_BOUNDED_WRITE_0f5e2ed521414bdab551e0e91180ec4a
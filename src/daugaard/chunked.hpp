@@ -0,0 +1,118 @@
+#ifndef DAUGAARD_RING_BUFFER_CHUNKED_f01d06fc48244549a79f24c15965f98a
+#define DAUGAARD_RING_BUFFER_CHUNKED_f01d06fc48244549a79f24c15965f98a
+
+// Records larger than the ring, sent as a sequence of fragments.  Each
+// fragment is published as soon as it is written, and the reader releases
+// it as soon as it has been consumed, so a record is only limited by the
+// fragment size, not by the size of the ring.
+//
+// A fragment is a ChunkHeader followed by its bytes.  The header holds the
+// size of the fragment and the number of bytes of the record that follow
+// it, so the reader knows the total size from the first fragment.  Fragments
+// of one record must not be interleaved with other writes.
+
+#include "ring_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+struct ChunkHeader
+{
+    std::uint64_t size;
+    std::uint64_t remaining;
+};
+
+// A fragment read from the ring.
+struct Chunk
+{
+    void const * data;
+    std::size_t size;
+    std::size_t remaining;
+};
+
+// Write and publish one fragment, followed by remaining bytes of the record.
+template <typename RingT>
+void
+WriteChunk(
+    RingT & ring,
+    void const * data,
+    std::size_t size,
+    std::size_t remaining)
+{
+    ring.Write(ChunkHeader{size, remaining});
+    std::memcpy(ring.PrepareWrite(size, 1), data, size);
+    ring.FinishWrite();
+}
+
+// Write and publish a record as fragments of at most chunkSize bytes.
+template <typename RingT>
+void
+WriteChunked(
+    RingT & ring,
+    void const * data,
+    std::size_t size,
+    std::size_t chunkSize)
+{
+    assert(chunkSize > 0);
+    char const * src = static_cast<char const *>(data);
+    do {
+        std::size_t n = std::min(size, chunkSize);
+        size -= n;
+        WriteChunk(ring, src, n, size);
+        src += n;
+    } while (size > 0);
+}
+
+// Read the next fragment.  Call FinishRead once it has been consumed, before
+// reading the next one, or a record larger than the ring can never complete.
+template <typename RingT>
+Chunk
+ReadChunk(RingT & ring)
+{
+    ChunkHeader header = ring.template Read<ChunkHeader>();
+    void const * data = ring.PrepareRead(header.size, 1);
+    return Chunk{data, header.size, header.remaining};
+}
+
+// Read a whole record into dest, releasing each fragment as it is copied.
+// Returns the size of the record.  If that is more than capacity, only the
+// first capacity bytes are copied, and the rest of the record is skipped.
+template <typename RingT>
+std::size_t
+ReadChunked(RingT & ring, void * dest, std::size_t capacity)
+{
+    char * out = static_cast<char *>(dest);
+    std::size_t total = 0;
+    for (;;) {
+        Chunk chunk = ReadChunk(ring);
+        if (total < capacity) {
+            std::memcpy(
+                out + total,
+                chunk.data,
+                std::min(chunk.size, capacity - total));
+        }
+        total += chunk.size;
+        ring.FinishRead();
+        if (chunk.remaining == 0) {
+            return total;
+        }
+    }
+}
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::Chunk;
+using rb::ChunkHeader;
+using rb::ReadChunk;
+using rb::ReadChunked;
+using rb::WriteChunk;
+using rb::WriteChunked;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_CHUNKED_f01d06fc48244549a79f24c15965f98a
@@ -0,0 +1,68 @@
+#ifndef DAUGAARD_RING_BUFFER_CPU_5dfd961419f74d579a3a649011fc3976
+#define DAUGAARD_RING_BUFFER_CPU_5dfd961419f74d579a3a649011fc3976
+
+// Small processor-specific helpers shared by the extensions.
+
+#include "ring_buffer.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb::detail {
+
+// Hint to the processor that this is a spin loop.
+DAUGAARD_RING_BUFFER_FORCE_INLINE void
+cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// A cheap, monotonic cycle counter.  Where the processor has none, this
+// falls back to nanoseconds of std::chrono::steady_clock.
+DAUGAARD_RING_BUFFER_FORCE_INLINE std::uint64_t
+read_cycle_counter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    std::uint64_t value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+// Rate of read_cycle_counter, measured once against steady_clock over about
+// ten milliseconds, the first time it is called.
+inline double
+cycles_per_microsecond()
+{
+    static double const rate = [] {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+        std::uint64_t startCycles = read_cycle_counter();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::uint64_t cycles = read_cycle_counter() - startCycles;
+        double us = std::chrono::duration<double, std::micro>(
+                        Clock::now() - start)
+                        .count();
+        return double(cycles) / us;
+    }();
+    return rate;
+}
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb::detail
+
+#endif // DAUGAARD_RING_BUFFER_CPU_5dfd961419f74d579a3a649011fc3976
@@ -0,0 +1,198 @@
+#ifndef DAUGAARD_RING_BUFFER_DISPATCH_PROFILER_34f062ba39e84af78fd83efa1bd94aae
+#define DAUGAARD_RING_BUFFER_DISPATCH_PROFILER_34f062ba39e84af78fd83efa1bd94aae
+
+// Which message types a reader spends its time on.  The reader's dispatch
+// loop passes each handler call through TDispatchProfiler::Dispatch, along
+// with the type of the message:
+//
+//     auto const & header = ring.Read<Header>();
+//     profiler.Dispatch(header.type, [&] { Handle(ring, header); });
+//     ring.FinishRead();
+//
+// One call in every SampleRate is timed with the cycle counter, and added
+// to a histogram for its type, with one bucket per power of two cycles.
+// The histograms may be read from any thread.  Only the reader updates
+// them, with plain loads and stores of relaxed atomics, so timing a call
+// costs two cycle counter reads and a few stores.
+//
+// A sample rate of zero turns sampling off, after which each call costs a
+// decrement and a branch.  The rate may be changed from any thread.  The
+// reader reloads it at least once every checkInterval calls, so a change
+// is picked up within checkInterval calls, whether sampling is on or off.
+
+#include "cpu.hpp"
+#include "ring_buffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+template <std::size_t TypeCount>
+class TDispatchProfiler
+{
+public:
+    inline static constexpr std::size_t bucketCount = 64;
+    inline static constexpr std::uint32_t checkInterval = 4096;
+
+    // A copy of the histogram of one type.  Bucket i counts calls that took
+    // from 2^i to 2^(i+1)-1 cycles; bucket 0 also counts calls of 0 cycles.
+    struct Histogram
+    {
+        std::uint64_t count;
+        std::uint64_t cycles;
+        std::uint64_t buckets[bucketCount];
+    };
+
+    explicit TDispatchProfiler(std::uint32_t sampleRate = 0)
+    {
+        m_Rate.value.store(sampleRate, std::memory_order_relaxed);
+        m_Reader.countdown = 1;
+        m_Reader.pending = 0;
+        for (Stats & stats : m_Stats) {
+            stats.count.store(0, std::memory_order_relaxed);
+            stats.cycles.store(0, std::memory_order_relaxed);
+            for (auto & bucket : stats.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    TDispatchProfiler(TDispatchProfiler const &) = delete;
+    TDispatchProfiler & operator = (TDispatchProfiler const &) = delete;
+
+    // Any thread: time one call in every sampleRate, or none if zero.
+    void SetSampleRate(std::uint32_t sampleRate)
+    {
+        m_Rate.value.store(sampleRate, std::memory_order_relaxed);
+    }
+
+    std::uint32_t SampleRate() const
+    {
+        return m_Rate.value.load(std::memory_order_relaxed);
+    }
+
+    // Reader: call f, which handles a message of the given type.
+    template <typename F>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void Dispatch(std::size_t type, F && f)
+    {
+        assert(type < TypeCount);
+        if (--m_Reader.countdown != 0) {
+            f();
+            return;
+        }
+        std::uint32_t rate = m_Rate.value.load(std::memory_order_relaxed);
+        if (rate == 0) {
+            m_Reader.countdown = checkInterval;
+            m_Reader.pending = 0;
+            f();
+            return;
+        }
+        // A lower rate takes effect at once.
+        if (m_Reader.pending > rate) {
+            m_Reader.pending = rate;
+        }
+        if (m_Reader.pending != 0) {
+            Step();
+            f();
+            return;
+        }
+        m_Reader.pending = rate;
+        Step();
+        std::uint64_t start = detail::read_cycle_counter();
+        f();
+        Add(type, detail::read_cycle_counter() - start);
+    }
+
+    // Any thread: a copy of the histogram of a type.  Counts added while
+    // the copy is made may be partly included.
+    Histogram Snapshot(std::size_t type) const
+    {
+        assert(type < TypeCount);
+        Stats const & stats = m_Stats[type];
+        Histogram result;
+        result.count = stats.count.load(std::memory_order_relaxed);
+        result.cycles = stats.cycles.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < bucketCount; i++) {
+            result.buckets[i] =
+                stats.buckets[i].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+private:
+    // Count down to the next sample, stopping at most checkInterval calls
+    // ahead to reload the rate.
+    void Step()
+    {
+        std::uint32_t step = std::min(m_Reader.pending, checkInterval);
+        m_Reader.pending -= step;
+        m_Reader.countdown = step;
+    }
+
+    static std::size_t BucketOf(std::uint64_t cycles)
+    {
+#if defined(__GNUC__)
+        return cycles == 0 ? 0 : 63 - __builtin_clzll(cycles);
+#else
+        std::size_t bucket = 0;
+        while (cycles >>= 1) {
+            bucket++;
+        }
+        return bucket;
+#endif
+    }
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void Add(
+        std::size_t type,
+        std::uint64_t cycles)
+    {
+        Stats & stats = m_Stats[type];
+        Increment(stats.count, 1);
+        Increment(stats.cycles, cycles);
+        Increment(stats.buckets[BucketOf(cycles)], 1);
+    }
+
+    // Only the reader writes, so this needs no read-modify-write.
+    static void Increment(std::atomic<std::uint64_t> & value, std::uint64_t n)
+    {
+        value.store(
+            value.load(std::memory_order_relaxed) + n,
+            std::memory_order_relaxed);
+    }
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) Stats
+    {
+        std::atomic<std::uint64_t> count;
+        std::atomic<std::uint64_t> cycles;
+        std::atomic<std::uint64_t> buckets[bucketCount];
+    };
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) ReaderState
+    {
+        // Calls until the rate is reloaded.
+        std::uint32_t countdown;
+        // Calls after that until the next sample.
+        std::uint32_t pending;
+    };
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) RateState
+    {
+        std::atomic<std::uint32_t> value;
+    };
+
+    ReaderState m_Reader;
+    RateState m_Rate;
+    Stats m_Stats[TypeCount];
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TDispatchProfiler;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_DISPATCH_PROFILER_34f062ba39e84af78fd83efa1bd94aae
@@ -0,0 +1,213 @@
+#ifndef DAUGAARD_RING_BUFFER_ELASTIC_1b4d31092fa3425e972de01ff32f0c79
+#define DAUGAARD_RING_BUFFER_ELASTIC_1b4d31092fa3425e972de01ff32f0c79
+
+// A ring whose resident memory follows its use rather than its capacity.
+// The buffer is reserved with MAP_NORESERVE, so pages are only committed
+// when the writer first touches them.  After a burst, the writer returns
+// the pages that hold neither unread data nor the space just ahead of the
+// writer, with madvise(MADV_DONTNEED).  They read back as zeros and are
+// committed again when the writer reaches them.
+//
+// The writer calls Poll while it has nothing to write.  Pages are released
+// once the writer has been idle for config.idle, and only if it has written
+// at least config.keep bytes since the last release, so a steady trickle
+// of writes does not make pages come and go.  Trim releases them at once.
+// Elsewhere than Linux, the buffer is ordinary memory and is never trimmed.
+
+#include "ring_buffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+#if defined(__linux__)
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+struct ElasticConfig
+{
+    // How long the writer must be idle before pages are released.
+    std::chrono::nanoseconds idle = std::chrono::milliseconds(100);
+
+    // Bytes ahead of the writer that are kept resident, and that the writer
+    // must write between releases.
+    std::size_t keep = std::size_t(1) << 16;
+};
+
+template <typename RingT>
+class TElasticRing
+{
+public:
+    // Throws if capacity is not a power of two at least a page in size, or
+    // if the memory can not be reserved.
+    explicit TElasticRing(
+        std::size_t capacity,
+        ElasticConfig const & config = ElasticConfig())
+    : m_Config(config)
+    , m_Capacity(capacity)
+    {
+        m_PageSize = PageSize();
+        if (capacity < m_PageSize) {
+            throw std::runtime_error("capacity must be at least a page");
+        }
+        m_Memory = Reserve(capacity);
+        try {
+            m_Ring.Initialize(m_Memory, capacity);
+        } catch (...) {
+            Unmap(m_Memory, capacity);
+            throw;
+        }
+        m_Writer.lastPosition = 0;
+        m_Writer.trimmedAt = 0;
+        m_Writer.lastProgress = Clock::now();
+    }
+
+    ~TElasticRing() { Unmap(m_Memory, m_Capacity); }
+
+    TElasticRing(TElasticRing const &) = delete;
+    TElasticRing & operator = (TElasticRing const &) = delete;
+
+    RingT & Ring() { return m_Ring; }
+
+    // Writer: release free pages if the policy allows it.  Returns the
+    // number of bytes released.
+    std::size_t Poll()
+    {
+        std::size_t position = m_Ring.WritePosition();
+        Clock::time_point now = Clock::now();
+        if (position != m_Writer.lastPosition) {
+            m_Writer.lastPosition = position;
+            m_Writer.lastProgress = now;
+            return 0;
+        }
+        if (now - m_Writer.lastProgress < m_Config.idle ||
+            position - m_Writer.trimmedAt < m_Config.keep)
+        {
+            return 0;
+        }
+        return Trim();
+    }
+
+    // Writer: release the pages between config.keep bytes ahead of the
+    // writer and the oldest unread data.  Returns the number of bytes
+    // released.
+    std::size_t Trim()
+    {
+        std::size_t position = m_Ring.WritePosition();
+        m_Writer.trimmedAt = position;
+        std::size_t start = RoundUp(position + m_Config.keep);
+        std::size_t end =
+            RoundDown(m_Ring.PublishedReadPosition() + m_Capacity);
+        if (static_cast<ptrdiff_t>(end - start) <= 0) {
+            return 0;
+        }
+
+        // The range may wrap around the end of the buffer.
+        std::size_t offset = start & (m_Capacity - 1);
+        std::size_t size = end - start;
+        std::size_t first = std::min(size, m_Capacity - offset);
+        Discard(m_Memory + offset, first);
+        if (size > first) {
+            Discard(m_Memory, size - first);
+        }
+        m_Writer.released += size;
+        return size;
+    }
+
+    // Total bytes released so far.
+    std::uint64_t ReleasedBytes() const { return m_Writer.released; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::size_t RoundUp(std::size_t n) const
+    {
+        return (n + m_PageSize - 1) & ~(m_PageSize - 1);
+    }
+
+    std::size_t RoundDown(std::size_t n) const
+    {
+        return n & ~(m_PageSize - 1);
+    }
+
+    static std::size_t PageSize()
+    {
+#if defined(__linux__)
+        return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 4096;
+#endif
+    }
+
+    static char * Reserve(std::size_t size)
+    {
+#if defined(__linux__)
+        void * memory = mmap(
+            nullptr,
+            size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+            -1,
+            0);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error("can not reserve ring memory");
+        }
+        return static_cast<char *>(memory);
+#else
+        return static_cast<char *>(::operator new(
+            size,
+            std::align_val_t(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE)));
+#endif
+    }
+
+    static void Unmap(char * memory, [[maybe_unused]] std::size_t size)
+    {
+#if defined(__linux__)
+        munmap(memory, size);
+#else
+        ::operator delete(
+            memory,
+            std::align_val_t(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE));
+#endif
+    }
+
+    static void Discard(
+        [[maybe_unused]] char * memory,
+        [[maybe_unused]] std::size_t size)
+    {
+#if defined(__linux__)
+        madvise(memory, size, MADV_DONTNEED);
+#endif
+    }
+
+    RingT m_Ring;
+    ElasticConfig m_Config;
+    std::size_t m_Capacity;
+    std::size_t m_PageSize;
+    char * m_Memory;
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) WriterState
+    {
+        std::size_t lastPosition;
+        std::size_t trimmedAt;
+        Clock::time_point lastProgress;
+        std::uint64_t released = 0;
+    };
+
+    WriterState m_Writer;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::ElasticConfig;
+using rb::TElasticRing;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_ELASTIC_1b4d31092fa3425e972de01ff32f0c79
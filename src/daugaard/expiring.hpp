@@ -0,0 +1,110 @@
+#ifndef DAUGAARD_RING_BUFFER_EXPIRING_20a6e27181644c338a1233ea701cc476
+#define DAUGAARD_RING_BUFFER_EXPIRING_20a6e27181644c338a1233ea701cc476
+
+// Records that carry an expiry time, so that a reader that has fallen behind
+// can skip data that is no longer worth handling.  Each record is an
+// ExpiryHeader followed by its payload.  ReadFresh reads headers until it
+// finds a record that has not expired, and steps over the payloads of the
+// others without loading them, so catching up after a stall costs a header
+// load per stale record instead of a pass over all of the stale data.
+//
+// Times are in whatever unit the writer and reader agree on, such as
+// nanoseconds of a steady clock, or cycle counter values.  A record with an
+// expiry of neverExpires is always handed to the reader.  The payload of a
+// record must be written and published together with its header.
+
+#include "ring_buffer.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+inline constexpr std::uint64_t neverExpires = 0;
+
+struct ExpiryHeader
+{
+    // The record is stale once the time is at least this.
+    std::uint64_t expiry;
+    std::uint32_t size;
+    std::uint32_t alignment;
+};
+
+// A record returned by ReadFresh.
+struct FreshRecord
+{
+    void const * data;
+    std::size_t size;
+    std::uint64_t expiry;
+};
+
+// Write a header, and allocate space for a payload that expires at the
+// given time.  Call FinishWrite on the ring as usual.
+template <typename RingT>
+DAUGAARD_RING_BUFFER_FORCE_INLINE void *
+PrepareExpiringWrite(
+    RingT & ring,
+    std::size_t size,
+    std::size_t alignment,
+    std::uint64_t expiry)
+{
+    assert(size <= UINT32_MAX);
+    assert(alignment <= UINT32_MAX);
+    ring.Write(ExpiryHeader{
+        expiry,
+        static_cast<std::uint32_t>(size),
+        static_cast<std::uint32_t>(alignment)});
+    return ring.PrepareWrite(size, alignment);
+}
+
+template <typename RingT, typename T>
+DAUGAARD_RING_BUFFER_FORCE_INLINE void
+WriteExpiring(RingT & ring, T const & value, std::uint64_t expiry)
+{
+    void * dest = PrepareExpiringWrite(ring, sizeof(T), alignof(T), expiry);
+    new (dest) T(value);
+}
+
+// Read the next published record that has not expired at now, skipping
+// the ones that have, and add the number skipped to skipped.  Returns false,
+// without waiting, once no published records are left.  Call FinishRead on
+// the ring as usual, which also releases the skipped records, including
+// after a call that returned false.
+template <typename RingT>
+bool
+ReadFresh(
+    RingT & ring,
+    std::uint64_t now,
+    FreshRecord & record,
+    std::size_t & skipped)
+{
+    while (not ring.ReadWouldWait(
+        sizeof(ExpiryHeader),
+        alignof(ExpiryHeader)))
+    {
+        ExpiryHeader const header = ring.template Read<ExpiryHeader>();
+        // The payload is only addressed, not loaded, when it is skipped.
+        void const * data = ring.PrepareRead(header.size, header.alignment);
+        if (header.expiry == neverExpires || now < header.expiry) {
+            record = FreshRecord{data, header.size, header.expiry};
+            return true;
+        }
+        skipped++;
+    }
+    return false;
+}
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::ExpiryHeader;
+using rb::FreshRecord;
+using rb::neverExpires;
+using rb::PrepareExpiringWrite;
+using rb::ReadFresh;
+using rb::WriteExpiring;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_EXPIRING_20a6e27181644c338a1233ea701cc476
@@ -0,0 +1,403 @@
+#ifndef DAUGAARD_RING_BUFFER_FLIGHT_RECORDER_26df3867c34d48d68d8b0056c3c20ce5
+#define DAUGAARD_RING_BUFFER_FLIGHT_RECORDER_26df3867c34d48d68d8b0056c3c20ce5
+
+// A record of what a ring did just before something went wrong.
+// TFlightRecorder keeps the last Capacity events of one side of a ring, each
+// with a cycle counter timestamp and a position.  Recording is a timestamp
+// and three stores into memory that only the owning thread touches, with no
+// locks or atomics.
+//
+// TFlightRecordingRing wraps a ring, and records publishes, releases, wraps,
+// and the start and end of each wait for the other side, in one recorder
+// for the writer and one for the reader.  WriteChromeTrace writes both as
+// Chrome trace_event JSON, which chrome://tracing and Perfetto can show.
+// The recorders are read without synchronization, so the trace should be
+// written when the two sides are stopped, or after a crash, when a few
+// of the most recent events may be torn.
+//
+// To write the trace from a crash or signal handler, use the overload that
+// takes a file descriptor and a buffer.  It formats into the buffer without
+// locale, allocation or locks, and writes it out with write(2).  The rate
+// of the cycle counter is measured when the ring is constructed, so that
+// nothing needs to be measured at the time of the crash.
+
+#include "cpu.hpp"
+#include "ring_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <unistd.h>
+#endif
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+enum class FlightEvent : std::uint32_t
+{
+    publish,
+    release,
+    wrap,
+    stall,
+    wake
+};
+
+namespace detail {
+
+// Formats a trace into a fixed buffer, and passes the buffer to
+// sink(data, size) each time it fills.  It uses only plain loads, stores
+// and arithmetic, so it is safe in a signal handler if the sink is.
+template <typename SinkT>
+class TraceFormatter
+{
+public:
+    TraceFormatter(char * buffer, std::size_t size, SinkT sink)
+    : m_Buffer(buffer)
+    , m_Size(size)
+    , m_Sink(sink)
+    {
+        assert(size > 0);
+    }
+
+    TraceFormatter(TraceFormatter const &) = delete;
+    TraceFormatter & operator = (TraceFormatter const &) = delete;
+
+    void Append(char c)
+    {
+        if (m_Used == m_Size) {
+            Flush();
+        }
+        m_Buffer[m_Used++] = c;
+    }
+
+    void Append(char const * text)
+    {
+        while (*text != '\0') {
+            Append(*text++);
+        }
+    }
+
+    void AppendUnsigned(std::uint64_t value)
+    {
+        char digits[20];
+        int count = 0;
+        do {
+            digits[count++] = char('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (count > 0) {
+            Append(digits[--count]);
+        }
+    }
+
+    // Append thousandths as a decimal with three places.
+    void AppendThousandths(std::uint64_t value)
+    {
+        AppendUnsigned(value / 1000);
+        Append('.');
+        Append(char('0' + value / 100 % 10));
+        Append(char('0' + value / 10 % 10));
+        Append(char('0' + value % 10));
+    }
+
+    // Pass what is left to the sink.  Returns false if any call to the
+    // sink failed.
+    bool Flush()
+    {
+        if (m_Used != 0 && not m_Sink(m_Buffer, m_Used)) {
+            m_Ok = false;
+        }
+        m_Used = 0;
+        return m_Ok;
+    }
+
+    // True until the first event has been appended.
+    bool first = true;
+
+private:
+    char * m_Buffer;
+    std::size_t m_Size;
+    SinkT m_Sink;
+    std::size_t m_Used = 0;
+    bool m_Ok = true;
+};
+
+} // namespace detail
+
+template <std::size_t Capacity = 256>
+class TFlightRecorder
+{
+    static_assert(
+        Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+        "Capacity must be a power of two");
+
+public:
+    struct Event
+    {
+        std::uint64_t cycles;
+        std::uint64_t position;
+        FlightEvent kind;
+    };
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void Record(
+        FlightEvent kind,
+        std::uint64_t position)
+    {
+        Event & event = m_Events[m_Next++ & (Capacity - 1)];
+        event.cycles = detail::read_cycle_counter();
+        event.position = position;
+        event.kind = kind;
+    }
+
+    // Number of events held, at most Capacity.
+    std::size_t Size() const
+    {
+        return std::min<std::uint64_t>(m_Next, Capacity);
+    }
+
+    // Call f with each event held, oldest first.
+    template <typename F>
+    void ForEach(F && f) const
+    {
+        for (std::uint64_t i = m_Next - Size(); i != m_Next; i++) {
+            f(m_Events[i & (Capacity - 1)]);
+        }
+    }
+
+    // Cycle count of the oldest event held, or ~0 if there is none.
+    std::uint64_t FirstCycles() const
+    {
+        return Size() ? m_Events[(m_Next - Size()) & (Capacity - 1)].cycles
+                      : ~std::uint64_t(0);
+    }
+
+    // Write the events as comma separated trace_event objects on thread
+    // tid, with times in microseconds since origin.
+    template <typename SinkT>
+    void WriteTraceEvents(
+        detail::TraceFormatter<SinkT> & out,
+        int tid,
+        std::uint64_t origin,
+        double cyclesPerMicrosecond) const;
+
+private:
+    Event m_Events[Capacity] = {};
+    std::uint64_t m_Next = 0;
+};
+
+template <std::size_t Capacity>
+template <typename SinkT>
+void
+TFlightRecorder<Capacity>::
+WriteTraceEvents(
+    detail::TraceFormatter<SinkT> & out,
+    int tid,
+    std::uint64_t origin,
+    double cyclesPerMicrosecond) const
+{
+    static char const * const names[] =
+        {"publish", "release", "wrap", "wait", "wait"};
+    double const nanosecondsPerCycle = 1000.0 / cyclesPerMicrosecond;
+    ForEach([&](Event const & event) {
+        auto kind = static_cast<std::uint32_t>(event.kind);
+        // After a crash, an event may be torn.
+        if (kind > static_cast<std::uint32_t>(FlightEvent::wake) ||
+            event.cycles < origin)
+        {
+            return;
+        }
+        // A wait is a duration event, from stall to wake.
+        char const * phase = event.kind == FlightEvent::stall ? "B"
+            : event.kind == FlightEvent::wake                 ? "E"
+                                                              : "i";
+        out.Append(out.first ? "\n{\"name\":\"" : ",\n{\"name\":\"");
+        out.first = false;
+        out.Append(names[kind]);
+        out.Append("\",\"ph\":\"");
+        out.Append(phase);
+        out.Append("\",\"ts\":");
+        out.AppendThousandths(static_cast<std::uint64_t>(
+            double(event.cycles - origin) * nanosecondsPerCycle));
+        out.Append(",\"pid\":0,\"tid\":");
+        out.AppendUnsigned(static_cast<std::uint64_t>(tid));
+        out.Append(",\"s\":\"t\",\"args\":{\"position\":");
+        out.AppendUnsigned(event.position);
+        out.Append("}}");
+    });
+}
+
+template <typename RingT, std::size_t Capacity = 256>
+class TFlightRecordingRing
+{
+public:
+    using Recorder = TFlightRecorder<Capacity>;
+
+    // Measures the rate of the cycle counter the first time a ring is
+    // constructed, which takes about ten milliseconds.
+    explicit TFlightRecordingRing(RingT & ring)
+    : m_Ring(ring)
+    , m_CyclesPerMicrosecond(detail::cycles_per_microsecond())
+    { }
+
+    TFlightRecordingRing(TFlightRecordingRing const &) = delete;
+    TFlightRecordingRing & operator = (TFlightRecordingRing const &) = delete;
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareWrite(
+        size_t size,
+        size_t alignment)
+    {
+        size_t before = m_Ring.WritePosition();
+        void * result;
+        if (m_Ring.WriteWouldWait(size, alignment)) {
+            m_Writer.recorder.Record(FlightEvent::stall, before);
+            result = m_Ring.PrepareWrite(size, alignment);
+            m_Writer.recorder.Record(FlightEvent::wake, before);
+        } else {
+            result = m_Ring.PrepareWrite(size, alignment);
+        }
+        RecordWrap(m_Writer.recorder, before, m_Ring.WritePosition());
+        return result;
+    }
+
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void Write(T const & value)
+    {
+        void * dest = PrepareWrite(sizeof(T), alignof(T));
+        new (dest) T(value);
+    }
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishWrite()
+    {
+        m_Ring.FinishWrite();
+        m_Writer.recorder.Record(FlightEvent::publish, m_Ring.WritePosition());
+    }
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareRead(
+        size_t size,
+        size_t alignment)
+    {
+        size_t before = m_Ring.ReadPosition();
+        void * result;
+        if (m_Ring.ReadWouldWait(size, alignment)) {
+            m_Reader.recorder.Record(FlightEvent::stall, before);
+            result = m_Ring.PrepareRead(size, alignment);
+            m_Reader.recorder.Record(FlightEvent::wake, before);
+        } else {
+            result = m_Ring.PrepareRead(size, alignment);
+        }
+        RecordWrap(m_Reader.recorder, before, m_Ring.ReadPosition());
+        return result;
+    }
+
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE const T & Read()
+    {
+        return *static_cast<T *>(PrepareRead(sizeof(T), alignof(T)));
+    }
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishRead()
+    {
+        m_Ring.FinishRead();
+        m_Reader.recorder.Record(FlightEvent::release, m_Ring.ReadPosition());
+    }
+
+    RingT & Ring() { return m_Ring; }
+    Recorder const & WriterRecorder() const { return m_Writer.recorder; }
+    Recorder const & ReaderRecorder() const { return m_Reader.recorder; }
+
+    // Write both recorders as a Chrome trace, with the writer on thread 1
+    // and the reader on thread 2.
+    void WriteChromeTrace(std::FILE * out) const
+    {
+        char buffer[4096];
+        auto sink = [out](char const * data, std::size_t count) {
+            return std::fwrite(data, 1, count, out) == count;
+        };
+        detail::TraceFormatter<decltype(sink)> formatter(
+            buffer,
+            sizeof(buffer),
+            sink);
+        FormatChromeTrace(formatter);
+        std::fflush(out);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // As above, but safe to call from a signal handler.  The trace is
+    // formatted into buffer, which may be of any size, and written to fd
+    // each time the buffer fills.  Returns false if a write failed.
+    bool WriteChromeTrace(int fd, char * buffer, std::size_t size) const
+    {
+        auto sink = [fd](char const * data, std::size_t count) {
+            while (count > 0) {
+                ssize_t written = ::write(fd, data, count);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written;
+                count -= static_cast<std::size_t>(written);
+            }
+            return true;
+        };
+        int savedErrno = errno;
+        detail::TraceFormatter<decltype(sink)> formatter(buffer, size, sink);
+        bool ok = FormatChromeTrace(formatter);
+        errno = savedErrno;
+        return ok;
+    }
+#endif
+
+private:
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void RecordWrap(
+        Recorder & recorder,
+        size_t before,
+        size_t after)
+    {
+        // The capacity is a power of two.
+        if ((before ^ after) & ~(m_Ring.Capacity() - 1)) {
+            recorder.Record(FlightEvent::wrap, after);
+        }
+    }
+
+    template <typename SinkT>
+    bool FormatChromeTrace(detail::TraceFormatter<SinkT> & out) const
+    {
+        std::uint64_t origin = std::min(
+            m_Writer.recorder.FirstCycles(),
+            m_Reader.recorder.FirstCycles());
+        out.Append("{\"traceEvents\":[");
+        m_Writer.recorder
+            .WriteTraceEvents(out, 1, origin, m_CyclesPerMicrosecond);
+        m_Reader.recorder
+            .WriteTraceEvents(out, 2, origin, m_CyclesPerMicrosecond);
+        out.Append("\n]}\n");
+        return out.Flush();
+    }
+
+    RingT & m_Ring;
+    double m_CyclesPerMicrosecond;
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) SideState
+    {
+        Recorder recorder;
+    };
+
+    SideState m_Writer;
+    SideState m_Reader;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::FlightEvent;
+using rb::TFlightRecorder;
+using rb::TFlightRecordingRing;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_FLIGHT_RECORDER_26df3867c34d48d68d8b0056c3c20ce5
@@ -0,0 +1,355 @@
+#ifndef DAUGAARD_RING_BUFFER_PER_CPU_c3ee475917ae4824a2b836d1264046e5
+#define DAUGAARD_RING_BUFFER_PER_CPU_c3ee475917ae4824a2b836d1264046e5
+
+// Many writers and one reader, with one ring per CPU rather than one per
+// writer thread.  A writer copies its record into the ring of the CPU it is
+// running on, inside a restartable sequence (rseq).  If the thread is
+// preempted, migrated or interrupted by a signal before the record is
+// published, the kernel aborts the sequence and the write starts again, so
+// threads on the same CPU never interleave and writers need no atomic
+// read-modify-write operations.  The reader drains every ring.
+//
+// The rings must be initialized, there must be one for each configured CPU,
+// and they must only be written through TPerCpuRings.  Records are copied
+// with memcpy, so must be trivially copyable.  Writers keep no local state:
+// the position of the next record is worked out from the published one.
+//
+// rseq is used on x86-64 Linux, with glibc 2.35 or later registering the
+// rseq area of each thread, when there is a ring for every possible CPU id.
+// CPU ids can be sparse, and CPUs can be brought online later, so this can
+// take more rings than there are configured CPUs.  Otherwise, each ring is
+// guarded by a spin lock, and writers use the ring of the CPU reported by
+// sched_getcpu, modulo the number of rings.
+
+#include "cpu.hpp"
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__linux__)
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__x86_64__) && defined(__GNUC__) && \
+    __has_include(<sys/rseq.h>)
+    #include <sys/rseq.h>
+    #define DAUGAARD_RING_BUFFER_HAS_RSEQ 1
+#endif
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+namespace detail {
+#ifdef DAUGAARD_RING_BUFFER_HAS_RSEQ
+inline bool
+rseq_available()
+{
+    return __rseq_size != 0;
+}
+
+// One more than the highest CPU id the kernel may ever report, from a list
+// such as "0-3,8-11".  Returns zero if it can not be read.
+inline std::size_t
+possible_cpu_count()
+{
+    std::FILE * file = std::fopen("/sys/devices/system/cpu/possible", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    std::size_t highest = 0;
+    std::size_t value = 0;
+    bool any = false;
+    for (int c = std::fgetc(file); c != EOF; c = std::fgetc(file)) {
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + static_cast<std::size_t>(c - '0');
+            any = true;
+        } else {
+            if (any && value > highest) {
+                highest = value;
+            }
+            value = 0;
+        }
+    }
+    std::fclose(file);
+    if (any && value > highest) {
+        highest = value;
+    }
+    return any ? highest + 1 : 0;
+}
+
+inline struct rseq *
+current_rseq()
+{
+    return reinterpret_cast<struct rseq *>(
+        static_cast<char *>(__builtin_thread_pointer()) + __rseq_offset);
+}
+
+// If the thread is still on cpu and cursor still holds expected, copy len
+// bytes from src to dst and store desired to cursor, all as one restartable
+// sequence.  Returns false if anything changed, or the sequence was aborted.
+template <typename AtomicT>
+inline bool
+rseq_copy_and_publish(
+    struct rseq * area,
+    std::uint32_t cpu,
+    AtomicT & cursor,
+    size_t expected,
+    void * dst,
+    void const * src,
+    size_t len,
+    size_t desired)
+{
+    asm goto(
+        ".pushsection __rseq_cs, \"aw\"\n\t"
+        ".balign 32\n\t"
+        "3:\n\t"
+        ".long 0x0, 0x0\n\t"
+        ".quad 1f, (2f - 1f), 4f\n\t"
+        ".popsection\n\t"
+        "leaq 3b(%%rip), %%rax\n\t"
+        "movq %%rax, %[rseq_cs]\n\t"
+        "1:\n\t"
+        "cmpl %[cpu], %[current_cpu]\n\t"
+        "jnz 4f\n\t"
+        "cmpq %[expected], %[cursor]\n\t"
+        "jnz %l[failed]\n\t"
+        "movq %[dst], %%rdi\n\t"
+        "movq %[src], %%rsi\n\t"
+        "movq %[len], %%rcx\n\t"
+        "rep movsb\n\t"
+        // The commit.  On x86-64 a plain store is a release.
+        "movq %[desired], %[cursor]\n\t"
+        "2:\n\t"
+        ".pushsection __rseq_failure, \"ax\"\n\t"
+        // The kernel checks for the signature just before the abort
+        // handler.  The prefix makes it decode as an undefined instruction.
+        ".byte 0x0f, 0xb9, 0x3d\n\t"
+        ".long %c[sig]\n\t"
+        "4:\n\t"
+        "jmp %l[failed]\n\t"
+        ".popsection\n\t"
+        :
+        : [cpu] "r"(cpu),
+          [current_cpu] "m"(area->cpu_id),
+          [rseq_cs] "m"(area->rseq_cs),
+          [cursor] "m"(cursor),
+          [expected] "r"(expected),
+          [desired] "r"(desired),
+          [dst] "r"(dst),
+          [src] "r"(src),
+          [len] "r"(len),
+          [sig] "i"(RSEQ_SIG)
+        : "memory", "cc", "rax", "rcx", "rsi", "rdi"
+        : failed);
+    return true;
+failed:
+    return false;
+}
+#endif
+} // namespace detail
+
+template <typename RingT>
+class TPerCpuRings
+{
+public:
+    // Throws if there are fewer rings than configured CPUs.  rseq is only
+    // used if there is a ring for every possible CPU id.
+    TPerCpuRings(RingT * rings, std::size_t count)
+    : m_Rings(rings)
+    , m_Count(count)
+    , m_Locks(new Lock[count])
+    {
+#if defined(__linux__)
+        long cpus = sysconf(_SC_NPROCESSORS_CONF);
+        if (cpus > 0 && count < static_cast<std::size_t>(cpus)) {
+            throw std::runtime_error("need a ring for each cpu");
+        }
+#endif
+        if (count == 0) {
+            throw std::runtime_error("need a ring for each cpu");
+        }
+#ifdef DAUGAARD_RING_BUFFER_HAS_RSEQ
+        std::size_t possible = detail::possible_cpu_count();
+        m_UseRseq =
+            detail::rseq_available() && possible != 0 && count >= possible;
+#endif
+        for (std::size_t i = 0; i < count; i++) {
+            m_Locks[i].locked.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    TPerCpuRings(TPerCpuRings const &) = delete;
+    TPerCpuRings & operator = (TPerCpuRings const &) = delete;
+
+    // Writer: copy a record into the ring of the current CPU, and publish
+    // it.  Returns false if that ring is full.
+    bool TryWrite(void const * data, size_t size, size_t alignment)
+    {
+#ifdef DAUGAARD_RING_BUFFER_HAS_RSEQ
+        if (m_UseRseq) {
+            struct rseq * area = detail::current_rseq();
+            for (;;) {
+                std::uint32_t cpu =
+                    __atomic_load_n(&area->cpu_id, __ATOMIC_RELAXED);
+                // Checked by the constructor.
+                assert(cpu < m_Count);
+                RingT & ring = m_Rings[cpu];
+                auto & cursor = detail::RingAccess::WriterCursor(ring);
+                size_t published = cursor.load(std::memory_order_relaxed);
+                size_t offset, next;
+                if (not Place(ring, published, size, alignment, offset, next)) {
+                    return false;
+                }
+                if (detail::rseq_copy_and_publish(
+                        area,
+                        cpu,
+                        cursor,
+                        published,
+                        detail::RingAccess::WriterBuffer(ring) + offset,
+                        data,
+                        size,
+                        next))
+                {
+                    return true;
+                }
+            }
+        }
+#endif
+        std::size_t index = CurrentCpu();
+        Lock & lock = m_Locks[index];
+        while (lock.locked.exchange(true, std::memory_order_acquire)) {
+            detail::cpu_relax();
+        }
+        RingT & ring = m_Rings[index];
+        auto & cursor = detail::RingAccess::WriterCursor(ring);
+        size_t published = cursor.load(std::memory_order_relaxed);
+        size_t offset, next;
+        bool placed = Place(ring, published, size, alignment, offset, next);
+        if (placed) {
+            std::memcpy(
+                detail::RingAccess::WriterBuffer(ring) + offset,
+                data,
+                size);
+            cursor.store(next, std::memory_order_release);
+        }
+        lock.locked.store(false, std::memory_order_release);
+        return placed;
+    }
+
+    // Writer: as TryWrite, but wait while the ring is full.
+    void Write(void const * data, size_t size, size_t alignment)
+    {
+        while (not TryWrite(data, size, alignment)) {
+            detail::cpu_relax();
+        }
+    }
+
+    template <typename T>
+    void Write(T const & value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Write(&value, sizeof(T), alignof(T));
+    }
+
+    // Reader: call f with each record of type T that has been published,
+    // ring by ring, and return the number of records read.
+    template <typename T, typename F>
+    std::size_t Drain(F && f)
+    {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < m_Count; i++) {
+            RingT & ring = m_Rings[i];
+            std::size_t count = 0;
+            while (not ring.ReadWouldWait(sizeof(T), alignof(T))) {
+                f(ring.template Read<T>());
+                count++;
+            }
+            if (count != 0) {
+                ring.FinishRead();
+                total += count;
+            }
+        }
+        return total;
+    }
+
+    // Reader: the rings, for records that Drain can not read.
+    RingT & Ring(std::size_t index) { return m_Rings[index]; }
+    std::size_t RingCount() const { return m_Count; }
+
+    // True if writers use restartable sequences rather than locks.
+    bool UsesRseq() const { return m_UseRseq; }
+
+private:
+    // Where a record goes, given the published position.  This follows the
+    // same rules as PrepareWrite, so the ring's reader finds it there.
+    static bool Place(
+        RingT & ring,
+        size_t published,
+        size_t size,
+        [[maybe_unused]] size_t alignment,
+        size_t & offset,
+        size_t & next)
+    {
+        size_t capacity = ring.Capacity();
+        assert(size <= capacity);
+        size_t base = published & ~(capacity - 1);
+        size_t pos = published - base;
+#ifndef DAUGAARD_RING_BUFFER_DO_NOT_ALIGN
+        pos = (pos + alignment - 1) & ~(alignment - 1);
+#endif
+        size_t end = pos + size;
+        if (end > capacity) {
+            pos = 0;
+            end = size;
+            base += capacity;
+        }
+        size_t readerPos = ring.PublishedReadPosition();
+        size_t available = readerPos - base + capacity;
+        // Signed comparison (available can be negative)
+        if (static_cast<ptrdiff_t>(available) < static_cast<ptrdiff_t>(end)) {
+            return false;
+        }
+        offset = pos;
+        next = base + end;
+        return true;
+    }
+
+    std::size_t CurrentCpu() const
+    {
+#if defined(__linux__)
+        int cpu = sched_getcpu();
+        if (cpu >= 0) {
+            return static_cast<std::size_t>(cpu) % m_Count;
+        }
+#endif
+        return 0;
+    }
+
+    // Only used when rseq is not, so writers on CPUs that share a ring are
+    // serialized.
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) Lock
+    {
+        std::atomic<bool> locked;
+    };
+
+    RingT * m_Rings;
+    std::size_t m_Count;
+    std::unique_ptr<Lock[]> m_Locks;
+    bool m_UseRseq = false;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TPerCpuRings;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_PER_CPU_c3ee475917ae4824a2b836d1264046e5
@@ -0,0 +1,153 @@
+#ifndef DAUGAARD_RING_BUFFER_PINNED_READER_5be3892fd2744e51a8528cba705fe7e0
+#define DAUGAARD_RING_BUFFER_PINNED_READER_5be3892fd2744e51a8528cba705fe7e0
+
+// A reader that lets records stay in the buffer after they have been read,
+// until they are released.  Records may be released out of order, and from
+// any thread, so they can be handed to asynchronous work without copying
+// them out first.  FinishRead makes buffer space available to the writer up
+// to the oldest record that is still pinned.
+//
+// The reader keeps the end of every record from the oldest one still pinned
+// to the newest one read, released or not, and has room for Capacity of
+// them.  So one record that stays pinned limits the reader to Capacity - 1
+// more reads, however many of those are released.  Past that, reads return
+// a null pointer until the oldest pinned record is released.  A pinned
+// record also holds its space in the ring, so a reader that keeps a pin
+// while waiting for a ring's worth of newer records waits forever on the
+// writer, which is waiting for that space.
+
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+template <typename RingT, std::size_t Capacity = 64>
+class TPinnedReader
+{
+    static_assert(
+        Capacity >= 64 && (Capacity & (Capacity - 1)) == 0,
+        "Capacity must be a power of two, and at least 64");
+
+public:
+    // A record that has been read, and the token that releases it.
+    template <typename T>
+    struct Pinned
+    {
+        T * data;
+        std::size_t token;
+    };
+
+    explicit TPinnedReader(RingT & ring)
+    : m_Ring(ring)
+    {
+        for (auto & word : m_Released) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    TPinnedReader(TPinnedReader const &) = delete;
+    TPinnedReader & operator = (TPinnedReader const &) = delete;
+
+    // Get read pointer and its release token. Size and alignment should match
+    // written data. Returns a null pointer, and reads nothing, if PinnedCount
+    // is still Capacity after FinishRead.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE Pinned<void> PreparePinnedRead(
+        size_t size,
+        size_t alignment)
+    {
+        if (PinnedCount() == Capacity) {
+            FinishRead();
+            if (PinnedCount() == Capacity) {
+                return Pinned<void>{nullptr, m_Tail};
+            }
+        }
+        void * src = m_Ring.PrepareRead(size, alignment);
+        m_Ends[m_Tail & (Capacity - 1)] = m_Ring.ReadPosition();
+        return Pinned<void>{src, m_Tail++};
+    }
+
+    // Read an element from the buffer, and pin it.
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE Pinned<T const> ReadPinned()
+    {
+        auto pinned = PreparePinnedRead(sizeof(T), alignof(T));
+        return Pinned<T const>{static_cast<T *>(pinned.data), pinned.token};
+    }
+
+    // Read an array of elements from the buffer, and pin it.
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE Pinned<T const> ReadPinnedArray(
+        size_t count)
+    {
+        auto pinned = PreparePinnedRead(sizeof(T) * count, alignof(T));
+        return Pinned<T const>{static_cast<T *>(pinned.data), pinned.token};
+    }
+
+    // Release a pinned record. May be called from any thread, but only once
+    // per token, and the record must not be touched afterwards.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void Release(std::size_t token)
+    {
+        std::size_t slot = token & (Capacity - 1);
+        [[maybe_unused]] std::uint64_t previous =
+            m_Released[slot / 64].fetch_or(
+                std::uint64_t(1) << (slot % 64),
+                std::memory_order_release);
+        assert((previous & (std::uint64_t(1) << (slot % 64))) == 0);
+    }
+
+    // Make buffer space available to writer, up to the oldest record that
+    // has not been released yet.
+    void FinishRead();
+
+    // Number of records read but not yet made available to writer, from the
+    // oldest one still pinned to the newest one read.  At most Capacity.
+    std::size_t PinnedCount() const { return m_Tail - m_Head; }
+
+private:
+    RingT & m_Ring;
+
+    // Token of the oldest record not yet made available to writer, and token
+    // of the next record to be read.
+    std::size_t m_Head = 0;
+    std::size_t m_Tail = 0;
+
+    // Absolute end position of each pinned record.
+    std::size_t m_Ends[Capacity];
+
+    // Completion bitmap, set by Release and cleared by FinishRead.
+    alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE)
+        std::atomic<std::uint64_t> m_Released[Capacity / 64];
+};
+
+template <typename RingT, std::size_t Capacity>
+void
+TPinnedReader<RingT, Capacity>::
+FinishRead()
+{
+    std::size_t const head = m_Head;
+    while (m_Head != m_Tail) {
+        std::size_t slot = m_Head & (Capacity - 1);
+        std::uint64_t bit = std::uint64_t(1) << (slot % 64);
+        auto & word = m_Released[slot / 64];
+        if ((word.load(std::memory_order_acquire) & bit) == 0) {
+            break;
+        }
+        word.fetch_and(~bit, std::memory_order_relaxed);
+        ++m_Head;
+    }
+    if (m_Head != head) {
+        m_Ring.FinishReadAt(m_Ends[(m_Head - 1) & (Capacity - 1)]);
+    }
+}
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TPinnedReader;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_PINNED_READER_5be3892fd2744e51a8528cba705fe7e0
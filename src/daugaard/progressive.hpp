@@ -0,0 +1,114 @@
+#ifndef DAUGAARD_RING_BUFFER_PROGRESSIVE_0684afbd3b3a47088f29ceb12796b0f0
+#define DAUGAARD_RING_BUFFER_PROGRESSIVE_0684afbd3b3a47088f29ceb12796b0f0
+
+// Records that are read while they are being written.  The writer publishes
+// the size of the record up front, then publishes its bytes as they are
+// filled in, and the reader can process each part as soon as it is
+// available.  For large records, the reader then lags the writer by about
+// one part, rather than by the whole record.
+//
+// A record is a std::uint64_t size, followed by its bytes with the given
+// alignment, which must be the same on both sides.  The whole record must
+// fit in the ring.
+
+#include "cpu.hpp"
+#include "ring_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+// Writes one record.  Other writes must not be made until the whole record
+// has been published.
+template <typename RingT>
+class TProgressiveWriter
+{
+public:
+    TProgressiveWriter(
+        RingT & ring,
+        std::size_t size,
+        std::size_t alignment = 1)
+    : m_Ring(ring)
+    , m_Size(size)
+    {
+        ring.Write(std::uint64_t(size));
+        m_Data = static_cast<char *>(ring.PrepareWrite(size, alignment));
+        m_Start = ring.WritePosition() - size;
+        ring.FinishWriteAt(m_Start);
+    }
+
+    TProgressiveWriter(TProgressiveWriter const &) = delete;
+    TProgressiveWriter & operator = (TProgressiveWriter const &) = delete;
+
+    char * Data() const { return m_Data; }
+    std::size_t Size() const { return m_Size; }
+
+    // Publish the first count bytes of the record.
+    void Publish(std::size_t count)
+    {
+        assert(count <= m_Size);
+        m_Ring.FinishWriteAt(m_Start + count);
+    }
+
+private:
+    RingT & m_Ring;
+    char * m_Data;
+    std::size_t m_Size;
+    std::size_t m_Start;
+};
+
+// Reads one record.  Call FinishRead on the ring once it has been consumed.
+template <typename RingT>
+class TProgressiveReader
+{
+public:
+    explicit TProgressiveReader(RingT & ring, std::size_t alignment = 1)
+    : m_Ring(ring)
+    , m_Size(ring.template Read<std::uint64_t>())
+    {
+        m_Data = static_cast<char const *>(ring.ReserveRead(m_Size, alignment));
+        m_Start = ring.ReadPosition() - m_Size;
+    }
+
+    TProgressiveReader(TProgressiveReader const &) = delete;
+    TProgressiveReader & operator = (TProgressiveReader const &) = delete;
+
+    char const * Data() const { return m_Data; }
+    std::size_t Size() const { return m_Size; }
+
+    // Number of bytes at the start of the record that have been published.
+    std::size_t Available() const
+    {
+        return std::min(m_Ring.PublishedWritePosition() - m_Start, m_Size);
+    }
+
+    // Wait until at least count bytes have been published, and return the
+    // number that have.
+    std::size_t WaitFor(std::size_t count) const
+    {
+        assert(count <= m_Size);
+        std::size_t available;
+        while ((available = Available()) < count) {
+            detail::cpu_relax();
+        }
+        return available;
+    }
+
+private:
+    RingT & m_Ring;
+    std::size_t m_Size;
+    char const * m_Data;
+    std::size_t m_Start;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TProgressiveReader;
+using rb::TProgressiveWriter;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_PROGRESSIVE_0684afbd3b3a47088f29ceb12796b0f0
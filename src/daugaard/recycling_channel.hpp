@@ -0,0 +1,116 @@
+#ifndef DAUGAARD_RING_BUFFER_RECYCLING_CHANNEL_6249f082da284f9d85f3111b4e12e68f
+#define DAUGAARD_RING_BUFFER_RECYCLING_CHANNEL_6249f082da284f9d85f3111b4e12e68f
+
+// Passes large payloads between two threads by pointer, instead of copying
+// them through the ring.  The forward ring carries frames, each a pointer to
+// a pooled buffer and the number of bytes used.  The reverse ring returns the
+// buffers to the producer once the consumer is done with them.
+//
+// Buffers are allocated and freed on the producer's thread only.  The pool
+// grows to at most bufferCount buffers; after that, Acquire waits for the
+// consumer to return one.  The reverse ring must have room for bufferCount
+// pointers, so returning a buffer never waits.
+
+#include "ring_buffer.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+template <typename RingT>
+class TRecyclingChannel
+{
+public:
+    // A buffer in flight, and the number of bytes of it that are used.
+    struct Frame
+    {
+        std::byte * data;
+        std::size_t size;
+    };
+
+    // Called on the producer's thread.
+    TRecyclingChannel(
+        RingT & forward,
+        RingT & reverse,
+        std::size_t bufferSize,
+        std::size_t bufferCount)
+    : m_Forward(forward)
+    , m_Reverse(reverse)
+    , m_BufferSize(bufferSize)
+    , m_BufferCount(bufferCount)
+    {
+        m_Buffers.reserve(bufferCount);
+    }
+
+    TRecyclingChannel(TRecyclingChannel const &) = delete;
+    TRecyclingChannel & operator = (TRecyclingChannel const &) = delete;
+
+    // Called on the producer's thread, once the consumer has stopped.
+    ~TRecyclingChannel()
+    {
+        for (std::byte * buffer : m_Buffers) {
+            ::operator delete (buffer, alignment);
+        }
+    }
+
+    // Producer: get a buffer of BufferSize bytes to fill.
+    std::byte * Acquire()
+    {
+        if (m_Buffers.size() < m_BufferCount) {
+            m_Buffers.push_back(static_cast<std::byte *>(
+                ::operator new (m_BufferSize, alignment)));
+            return m_Buffers.back();
+        }
+        std::byte * buffer = m_Reverse.template Read<std::byte *>();
+        m_Reverse.FinishRead();
+        return buffer;
+    }
+
+    // Producer: pass a filled buffer to the consumer.
+    void Publish(std::byte * buffer, std::size_t size)
+    {
+        assert(size <= m_BufferSize);
+        m_Forward.Write(Frame{buffer, size});
+        m_Forward.FinishWrite();
+    }
+
+    // Consumer: get the next frame.
+    Frame Receive()
+    {
+        Frame frame = m_Forward.template Read<Frame>();
+        m_Forward.FinishRead();
+        return frame;
+    }
+
+    // Consumer: return a buffer to the producer's pool.
+    void Recycle(std::byte * buffer)
+    {
+        m_Reverse.Write(buffer);
+        m_Reverse.FinishWrite();
+    }
+
+    std::size_t BufferSize() const { return m_BufferSize; }
+
+private:
+    static constexpr std::align_val_t alignment{
+        DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE};
+
+    RingT & m_Forward;
+    RingT & m_Reverse;
+    std::size_t m_BufferSize;
+    std::size_t m_BufferCount;
+
+    // Every buffer allocated so far, owned by the producer.
+    std::vector<std::byte *> m_Buffers;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TRecyclingChannel;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_RECYCLING_CHANNEL_6249f082da284f9d85f3111b4e12e68f
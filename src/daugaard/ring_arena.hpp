@@ -0,0 +1,169 @@
+#ifndef DAUGAARD_RING_BUFFER_RING_ARENA_77982e05c63346da8d850c1c15320554
+#define DAUGAARD_RING_BUFFER_RING_ARENA_77982e05c63346da8d850c1c15320554
+
+// Many rings in one block of memory backed by huge pages.  The rings'
+// control state is packed together at the start of the block, followed by
+// their buffers, so thousands of rings are covered by a few TLB entries
+// rather than one or more 4 KiB pages each.
+//
+// The block is mapped with MAP_HUGETLB where huge pages have been reserved.
+// Otherwise it is aligned on a huge page and marked with MADV_HUGEPAGE, so
+// transparent huge pages can back it.  Elsewhere it is ordinary memory.
+//
+// CompactRingBuffer aligns its control state on size_t rather than on a
+// cache line, so it takes 96 bytes rather than 256 on 64-bit platforms.
+// The writer and reader then share cache lines, so it suits rings that are
+// idle most of the time, such as one per connection.
+
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__linux__)
+    #include <sys/mman.h>
+#endif
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+struct CompactRingBuffer
+: TRingBuffer<std::atomic<size_t>, alignof(size_t)>
+{ };
+
+template <typename RingT>
+class TRingArena
+{
+public:
+    static_assert(std::is_trivially_destructible_v<RingT>);
+
+    inline static constexpr std::size_t hugePageSize = std::size_t(2) << 20;
+
+    // Create count rings of ringSize bytes each, initialized.  Throws if the
+    // memory can not be mapped, or if Initialize throws.
+    TRingArena(std::size_t count, std::size_t ringSize)
+    : m_Count(count)
+    {
+        std::size_t controlSize = RoundUp(
+            sizeof(RingT) * count,
+            DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE);
+        std::size_t stride =
+            RoundUp(ringSize, DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE);
+        m_Size = RoundUp(controlSize + stride * count, hugePageSize);
+        m_Memory = static_cast<char *>(Map(m_Size, m_HugePages));
+
+        m_Rings = reinterpret_cast<RingT *>(m_Memory);
+        char * buffer = m_Memory + controlSize;
+        try {
+            for (std::size_t i = 0; i < count; i++) {
+                RingT * ring = new (m_Rings + i) RingT;
+                ring->Initialize(buffer + i * stride, ringSize);
+            }
+        } catch (...) {
+            Unmap(m_Memory, m_Size);
+            throw;
+        }
+    }
+
+    ~TRingArena() { Unmap(m_Memory, m_Size); }
+
+    TRingArena(TRingArena const &) = delete;
+    TRingArena & operator = (TRingArena const &) = delete;
+
+    RingT & Ring(std::size_t index)
+    {
+        assert(index < m_Count);
+        return m_Rings[index];
+    }
+
+    std::size_t RingCount() const { return m_Count; }
+
+    // Bytes mapped for the control state and buffers of all rings.
+    std::size_t Size() const { return m_Size; }
+
+    // True if the memory came from the reserved huge page pool, rather than
+    // from transparent huge pages or ordinary pages.
+    bool UsesReservedHugePages() const { return m_HugePages; }
+
+private:
+    static constexpr std::size_t RoundUp(std::size_t n, std::size_t align)
+    {
+        return (n + align - 1) / align * align;
+    }
+
+    static void * Map(std::size_t size, bool & hugePages)
+    {
+#if defined(__linux__)
+        void * memory = mmap(
+            nullptr,
+            size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+            -1,
+            0);
+        if (memory != MAP_FAILED) {
+            hugePages = true;
+            return memory;
+        }
+        hugePages = false;
+
+        // Map a huge page more than needed, and trim it to a huge page
+        // boundary, so transparent huge pages can back all of it.
+        std::size_t padded = size + hugePageSize;
+        memory = mmap(
+            nullptr,
+            padded,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS,
+            -1,
+            0);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error("can not map ring arena");
+        }
+        char * start = static_cast<char *>(memory);
+        char * aligned = reinterpret_cast<char *>(RoundUp(
+            reinterpret_cast<std::uintptr_t>(start),
+            hugePageSize));
+        if (aligned != start) {
+            munmap(start, aligned - start);
+        }
+        munmap(aligned + size, start + padded - (aligned + size));
+        madvise(aligned, size, MADV_HUGEPAGE);
+        return aligned;
+#else
+        hugePages = false;
+        return ::operator new(size, std::align_val_t(hugePageSize));
+#endif
+    }
+
+    static void Unmap(void * memory, [[maybe_unused]] std::size_t size)
+    {
+#if defined(__linux__)
+        munmap(memory, size);
+#else
+        ::operator delete(memory, std::align_val_t(hugePageSize));
+#endif
+    }
+
+    RingT * m_Rings;
+    std::size_t m_Count;
+    char * m_Memory;
+    std::size_t m_Size;
+    bool m_HugePages;
+};
+
+using RingArena = TRingArena<CompactRingBuffer>;
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::CompactRingBuffer;
+using rb::RingArena;
+using rb::TRingArena;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_RING_ARENA_77982e05c63346da8d850c1c15320554
@@ -36,12 +36,48 @@
 //    meant that the class was not trivially default constructible.
 //    This is not absolutely necessary, but means that it can only
 //    combine with other things that are trivially move/copy.
+//
+// 9. ReadPosition and FinishReadAt have been added so the reader can
+//    release buffer space up to a position other than its current one.
+//    This allows records to be held past the next read.
+//
+// 10. WriteTransaction has been added, so a group of writes can be published
+//     together or discarded.
+//
+// 11. WriteMany and ReadMany have been added to write and read a group of
+//     elements with a single reservation.
+//
+// 12. WriteSession and ReadSession have been added.  They keep the local
+//     state in local variables while many elements are written or read.
+//
+// 13. The alignment of the local and shared state is a template parameter.
+//     Together with PlainCursor, this gives SingleThreadedRingBuffer, which
+//     has no atomics and no padding.
+//
+// 14. WritePosition, FinishWriteAt, ReserveRead and PublishedWritePosition
+//     have been added, so a record can be read while it is being written.
+//
+// 15. Capacity, PublishedReadPosition, WriteWouldWait and ReadWouldWait
+//     have been added, so callers can observe how full the buffer is.
+//
+// 16. The wait strategy used while the buffer is full or empty is a template
+//     parameter.  The default, BusySpin, does what the original did.
+//
+// 17. detail::RingAccess gives extensions access to the writer's buffer and
+//     shared position, for writers that keep no local state.
+//
+// 18. TryPrepareWrite has been added, which gives up after waiting a given
+//     number of times for the reader, and leaves the writer unchanged.
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
 #include <new>
 #include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 #ifndef DAUGAARD_RING_BUFFER_FORCE_INLINE
     #if defined(_MSC_VER)
@@ -106,10 +142,69 @@ get_runtime_cache_line_size()
 } // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb::detail
 #endif
 
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb::detail {
+// Layout of a group of elements written with a single reservation.  Offsets
+// are relative to a start aligned for the most aligned element.
+template <typename... Ts>
+struct GroupLayout
+{
+    static constexpr std::size_t alignment = std::max({alignof(Ts)...});
+
+    static constexpr std::array<std::size_t, sizeof...(Ts) + 1> compute()
+    {
+        std::array<std::size_t, sizeof...(Ts) + 1> result{};
+        std::size_t pos = 0;
+        std::size_t i = 0;
+#ifdef DAUGAARD_RING_BUFFER_DO_NOT_ALIGN
+        ((result[i++] = pos, pos += sizeof(Ts)), ...);
+#else
+        ((pos = (pos + alignof(Ts) - 1) & ~(alignof(Ts) - 1),
+          result[i++] = pos,
+          pos += sizeof(Ts)),
+         ...);
+#endif
+        result[i] = pos;
+        return result;
+    }
+
+    static constexpr std::array<std::size_t, sizeof...(Ts) + 1> offsets =
+        compute();
+    static constexpr std::size_t size = offsets[sizeof...(Ts)];
+};
+
+struct RingAccess;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb::detail
 
 namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
 
-template <typename AtomicT>
+// Cursor for a buffer whose writer and reader are on the same thread.  The
+// published positions are plain loads and stores, without atomics.  They
+// are still only updated by FinishWrite and FinishRead, so data must be
+// published with FinishWrite before it can be read, and space released
+// with FinishRead before it can be written again.
+struct PlainCursor
+{
+    size_t value;
+
+    size_t load(std::memory_order) const { return value; }
+    void store(size_t desired, std::memory_order) { value = desired; }
+};
+
+// Wait strategy that spins on the other side's position.
+struct BusySpin
+{
+    template <typename AtomicT>
+    static void Wait(AtomicT const &, size_t)
+    { }
+};
+
+// Alignment is that of the writer and reader's state.  The default keeps
+// each part of the state on its own cache line.  WaitT::Wait(pos, observed)
+// is called each time the other side's position is found to be too small.
+template <
+    typename AtomicT,
+    std::size_t Alignment = DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE,
+    typename WaitT = BusySpin>
 class TRingBuffer
 {
 public:
@@ -122,9 +217,36 @@ public:
         size_t size,
         size_t alignment);
 
+    // As PrepareWrite, but wait for the reader at most spins times.  Returns
+    // nullptr, and changes nothing, if there is still not enough space.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * TryPrepareWrite(
+        size_t size,
+        size_t alignment,
+        size_t spins);
+
     // Publish written data.
     DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishWrite();
 
+    // Publish written data up to an absolute position, as returned by
+    // WritePosition.  The position may be inside the last prepared write.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishWriteAt(size_t position);
+
+    // Absolute position of the end of the last write.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE size_t WritePosition() const
+    {
+        return m_Writer.base + m_Writer.pos;
+    }
+
+    // A group of writes that is published or discarded as a whole.
+    class WriteTransaction;
+
+    // Start a write transaction at the current write position.
+    WriteTransaction BeginWrite();
+
+    // Writer and reader that hold the local state in local variables.
+    class WriteSession;
+    class ReadSession;
+
     // Write an element to the buffer.
     template <typename T>
     DAUGAARD_RING_BUFFER_FORCE_INLINE void Write(T const & value)
@@ -145,6 +267,19 @@ public:
         }
     }
 
+    // Write a group of elements to the buffer, with one reservation. The
+    // group must be read back with ReadMany, using the same types.
+    template <typename... Ts>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void WriteMany(Ts const &... values)
+    {
+        using Layout = detail::GroupLayout<Ts...>;
+        void * dest = PrepareWrite(Layout::size, Layout::alignment);
+        WriteGroup(
+            static_cast<char *>(dest),
+            std::index_sequence_for<Ts...>{},
+            values...);
+    }
+
     // Get read pointer. Size and alignment should match written data.
     DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareRead(
         size_t size,
@@ -153,6 +288,50 @@ public:
     // Finish and make buffer space available to writer.
     DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishRead();
 
+    // Make buffer space up to an absolute position, as returned by
+    // ReadPosition, available to writer.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishReadAt(size_t position);
+
+    // Absolute position of the end of the last read.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE size_t ReadPosition() const
+    {
+        return m_Reader.base + m_Reader.pos;
+    }
+
+    // Get read pointer without waiting for the data to be published. Size and
+    // alignment should match written data. Use PublishedWritePosition to
+    // find out how much of it is available.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * ReserveRead(
+        size_t size,
+        size_t alignment);
+
+    // Absolute position up to which the writer has published.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE size_t PublishedWritePosition() const
+    {
+        return m_WriterShared.pos.load(std::memory_order_acquire);
+    }
+
+    // Absolute position up to which the reader has finished.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE size_t PublishedReadPosition() const
+    {
+        return m_ReaderShared.pos.load(std::memory_order_acquire);
+    }
+
+    // Size of the buffer.
+    size_t Capacity() const { return m_Writer.size; }
+
+    // True if PrepareWrite would have to wait for the reader.  Only looks at
+    // the reader's position when the space known to be free is too small.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE bool WriteWouldWait(
+        size_t size,
+        size_t alignment) const;
+
+    // True if PrepareRead would have to wait for the writer.  Only looks at
+    // the writer's position when the data known to be published is too small.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE bool ReadWouldWait(
+        size_t size,
+        size_t alignment) const;
+
     // Read an element from the buffer.
     template <typename T>
     DAUGAARD_RING_BUFFER_FORCE_INLINE const T & Read()
@@ -169,6 +348,17 @@ public:
         return static_cast<T *>(src);
     }
 
+    // Read a group of elements written with WriteMany.
+    template <typename... Ts>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE std::tuple<Ts const &...> ReadMany()
+    {
+        using Layout = detail::GroupLayout<Ts...>;
+        void * src = PrepareRead(Layout::size, Layout::alignment);
+        return ReadGroup<Ts...>(
+            static_cast<char *>(src),
+            std::index_sequence_for<Ts...>{});
+    }
+
     // Initialize. Buffer must have required alignment. Size must be a power of
     // two.
     void Initialize(void * buffer, size_t size)
@@ -212,6 +402,8 @@ public:
     }
 
 private:
+    friend struct detail::RingAccess;
+
     template <typename T>
     static constexpr bool is_power_of_two(T t)
     {
@@ -230,15 +422,35 @@ private:
 #endif
     }
 
+    template <typename... Ts, std::size_t... Is>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE static void WriteGroup(
+        char * dest,
+        std::index_sequence<Is...>,
+        Ts const &... values)
+    {
+        using Layout = detail::GroupLayout<Ts...>;
+        (new (static_cast<void *>(dest + Layout::offsets[Is])) Ts(values), ...);
+    }
+
+    template <typename... Ts, std::size_t... Is>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE static std::tuple<Ts const &...>
+    ReadGroup(char * src, std::index_sequence<Is...>)
+    {
+        using Layout = detail::GroupLayout<Ts...>;
+        return std::tuple<Ts const &...>(
+            *reinterpret_cast<Ts *>(src + Layout::offsets[Is])...);
+    }
+
     DAUGAARD_RING_BUFFER_FORCE_INLINE void GetBufferSpaceToWriteTo(
         size_t & pos,
         size_t & end);
+    bool TryGetBufferSpaceToWriteTo(size_t & pos, size_t & end, size_t spins);
     DAUGAARD_RING_BUFFER_FORCE_INLINE void GetBufferSpaceToReadFrom(
         size_t & pos,
         size_t & end);
 
     // Writer and reader's local state.
-    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) LocalState
+    struct alignas(Alignment) LocalState
     {
         char * buffer;
         size_t pos;
@@ -251,7 +463,7 @@ private:
     LocalState m_Reader;
 
     // Writer and reader's shared positions.
-    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) SharedState
+    struct alignas(Alignment) SharedState
     {
         AtomicT pos;
     };
@@ -260,9 +472,216 @@ private:
     SharedState m_ReaderShared;
 };
 
-template <typename AtomicT>
+// Writes made while a transaction is open are published together by Commit,
+// or discarded by Rollback, as if they had never been made.  Destroying an
+// open transaction rolls it back.  FinishWrite must not be called while a
+// transaction is open.
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+class TRingBuffer<AtomicT, Alignment, WaitT>::WriteTransaction
+{
+public:
+    explicit WriteTransaction(TRingBuffer & ring)
+    : m_Ring(&ring)
+    , m_Saved(ring.m_Writer)
+    { }
+
+    WriteTransaction(WriteTransaction const &) = delete;
+    WriteTransaction & operator = (WriteTransaction const &) = delete;
+
+    ~WriteTransaction()
+    {
+        if (m_Ring) {
+            Rollback();
+        }
+    }
+
+    // Publish all writes made since the transaction started.
+    void Commit()
+    {
+        assert(m_Ring);
+        m_Ring->FinishWrite();
+        m_Ring = nullptr;
+    }
+
+    // Discard all writes made since the transaction started.
+    void Rollback()
+    {
+        assert(m_Ring);
+        m_Ring->m_Writer = m_Saved;
+        m_Ring = nullptr;
+    }
+
+private:
+    TRingBuffer * m_Ring;
+    LocalState m_Saved;
+};
+
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+auto
+TRingBuffer<AtomicT, Alignment, WaitT>::
+BeginWrite()
+-> WriteTransaction
+{
+    return WriteTransaction(*this);
+}
+
+// Stores through the buffer pointer may alias the writer's local state, so
+// the compiler reloads it after every element written.  A session copies the
+// state into its own members, which stay in registers when the session is a
+// local variable, and writes it back when the session ends.  The ring's own
+// write functions must not be used while a session is open.
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+class TRingBuffer<AtomicT, Alignment, WaitT>::WriteSession
+{
+public:
+    explicit WriteSession(TRingBuffer & ring)
+    : m_Ring(ring)
+    , m_Buffer(ring.m_Writer.buffer)
+    , m_Pos(ring.m_Writer.pos)
+    , m_End(ring.m_Writer.end)
+    , m_Base(ring.m_Writer.base)
+    { }
+
+    WriteSession(WriteSession const &) = delete;
+    WriteSession & operator = (WriteSession const &) = delete;
+
+    ~WriteSession() { m_Ring.m_Writer.pos = m_Pos; }
+
+    // Allocate buffer space for writing.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareWrite(
+        size_t size,
+        size_t alignment)
+    {
+        size_t pos = Align(m_Pos, alignment);
+        size_t end = pos + size;
+        assert(end - m_Pos <= m_Ring.m_Writer.size);
+        if (end > m_End) {
+            GetBufferSpaceToWriteTo(pos, end);
+        }
+        m_Pos = end;
+        return m_Buffer + pos;
+    }
+
+    // Publish written data.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishWrite()
+    {
+        m_Ring.m_WriterShared.pos.store(
+            m_Base + m_Pos,
+            std::memory_order_release);
+    }
+
+    // Write an element to the buffer.
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void Write(T const & value)
+    {
+        void * dest = PrepareWrite(sizeof(T), alignof(T));
+        new (dest) T(value);
+    }
+
+    // Write an array of elements to the buffer.
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void WriteArray(
+        T const * values,
+        size_t count)
+    {
+        void * dest = PrepareWrite(sizeof(T) * count, alignof(T));
+        for (size_t i = 0; i < count; i++) {
+            new (static_cast<void *>(static_cast<T *>(dest) + i)) T(values[i]);
+        }
+    }
+
+private:
+    void GetBufferSpaceToWriteTo(size_t & pos, size_t & end)
+    {
+        m_Ring.m_Writer.pos = m_Pos;
+        m_Ring.GetBufferSpaceToWriteTo(pos, end);
+        m_End = m_Ring.m_Writer.end;
+        m_Base = m_Ring.m_Writer.base;
+    }
+
+    TRingBuffer & m_Ring;
+    char * m_Buffer;
+    size_t m_Pos;
+    size_t m_End;
+    size_t m_Base;
+};
+
+// The reading counterpart of WriteSession.
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+class TRingBuffer<AtomicT, Alignment, WaitT>::ReadSession
+{
+public:
+    explicit ReadSession(TRingBuffer & ring)
+    : m_Ring(ring)
+    , m_Buffer(ring.m_Reader.buffer)
+    , m_Pos(ring.m_Reader.pos)
+    , m_End(ring.m_Reader.end)
+    , m_Base(ring.m_Reader.base)
+    { }
+
+    ReadSession(ReadSession const &) = delete;
+    ReadSession & operator = (ReadSession const &) = delete;
+
+    ~ReadSession() { m_Ring.m_Reader.pos = m_Pos; }
+
+    // Get read pointer. Size and alignment should match written data.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareRead(
+        size_t size,
+        size_t alignment)
+    {
+        size_t pos = Align(m_Pos, alignment);
+        size_t end = pos + size;
+        assert(end - m_Pos <= m_Ring.m_Reader.size);
+        if (end > m_End) {
+            GetBufferSpaceToReadFrom(pos, end);
+        }
+        m_Pos = end;
+        return m_Buffer + pos;
+    }
+
+    // Finish and make buffer space available to writer.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishRead()
+    {
+        m_Ring.m_ReaderShared.pos.store(
+            m_Base + m_Pos,
+            std::memory_order_release);
+    }
+
+    // Read an element from the buffer.
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE const T & Read()
+    {
+        void * src = PrepareRead(sizeof(T), alignof(T));
+        return *static_cast<T *>(src);
+    }
+
+    // Read an array of elements from the buffer.
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE const T * ReadArray(size_t count)
+    {
+        void * src = PrepareRead(sizeof(T) * count, alignof(T));
+        return static_cast<T *>(src);
+    }
+
+private:
+    void GetBufferSpaceToReadFrom(size_t & pos, size_t & end)
+    {
+        m_Ring.m_Reader.pos = m_Pos;
+        m_Ring.GetBufferSpaceToReadFrom(pos, end);
+        m_End = m_Ring.m_Reader.end;
+        m_Base = m_Ring.m_Reader.base;
+    }
+
+    TRingBuffer & m_Ring;
+    char * m_Buffer;
+    size_t m_Pos;
+    size_t m_End;
+    size_t m_Base;
+};
+
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
 void *
-TRingBuffer<AtomicT>::
+TRingBuffer<AtomicT, Alignment, WaitT>::
 PrepareWrite(size_t size, size_t alignment)
 {
     size_t pos = Align(m_Writer.pos, alignment);
@@ -275,9 +694,25 @@ PrepareWrite(size_t size, size_t alignment)
     return m_Writer.buffer + pos;
 }
 
-template <typename AtomicT>
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+void *
+TRingBuffer<AtomicT, Alignment, WaitT>::
+TryPrepareWrite(size_t size, size_t alignment, size_t spins)
+{
+    size_t pos = Align(m_Writer.pos, alignment);
+    size_t end = pos + size;
+    assert(end - m_Writer.pos <= m_Writer.size);
+    if (end > m_Writer.end && not TryGetBufferSpaceToWriteTo(pos, end, spins))
+    {
+        return nullptr;
+    }
+    m_Writer.pos = end;
+    return m_Writer.buffer + pos;
+}
+
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
 void
-TRingBuffer<AtomicT>::
+TRingBuffer<AtomicT, Alignment, WaitT>::
 FinishWrite()
 {
     m_WriterShared.pos.store(
@@ -285,9 +720,9 @@ FinishWrite()
         std::memory_order_release);
 }
 
-template <typename AtomicT>
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
 void *
-TRingBuffer<AtomicT>::
+TRingBuffer<AtomicT, Alignment, WaitT>::
 PrepareRead(size_t size, size_t alignment)
 {
     size_t pos = Align(m_Reader.pos, alignment);
@@ -300,9 +735,9 @@ PrepareRead(size_t size, size_t alignment)
     return m_Reader.buffer + pos;
 }
 
-template <typename AtomicT>
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
 void
-TRingBuffer<AtomicT>::
+TRingBuffer<AtomicT, Alignment, WaitT>::
 FinishRead()
 {
     m_ReaderShared.pos.store(
@@ -310,11 +745,91 @@ FinishRead()
         std::memory_order_release);
 }
 
-template <typename AtomicT>
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
 void
-TRingBuffer<AtomicT>::
+TRingBuffer<AtomicT, Alignment, WaitT>::
+FinishWriteAt(size_t position)
+{
+    assert(static_cast<ptrdiff_t>(WritePosition() - position) >= 0);
+    m_WriterShared.pos.store(position, std::memory_order_release);
+}
+
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+void *
+TRingBuffer<AtomicT, Alignment, WaitT>::
+ReserveRead(size_t size, size_t alignment)
+{
+    size_t pos = Align(m_Reader.pos, alignment);
+    size_t end = pos + size;
+    assert(end - m_Reader.pos <= m_Reader.size);
+    if (end > m_Reader.size) {
+        end -= pos;
+        pos = 0;
+        m_Reader.base += m_Reader.size;
+        // Nothing is known to be available after the wrap.
+        m_Reader.end = 0;
+    }
+    m_Reader.pos = end;
+    return m_Reader.buffer + pos;
+}
+
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+bool
+TRingBuffer<AtomicT, Alignment, WaitT>::
+WriteWouldWait(size_t size, size_t alignment) const
+{
+    size_t pos = Align(m_Writer.pos, alignment);
+    size_t end = pos + size;
+    if (end <= m_Writer.end) {
+        return false;
+    }
+    size_t base = m_Writer.base;
+    if (end > m_Writer.size) {
+        end -= pos;
+        base += m_Writer.size;
+    }
+    size_t readerPos = m_ReaderShared.pos.load(std::memory_order_acquire);
+    size_t available = readerPos - base + m_Writer.size;
+    // Signed comparison (available can be negative)
+    return static_cast<ptrdiff_t>(available) < static_cast<ptrdiff_t>(end);
+}
+
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+bool
+TRingBuffer<AtomicT, Alignment, WaitT>::
+ReadWouldWait(size_t size, size_t alignment) const
+{
+    size_t pos = Align(m_Reader.pos, alignment);
+    size_t end = pos + size;
+    if (end <= m_Reader.end) {
+        return false;
+    }
+    size_t base = m_Reader.base;
+    if (end > m_Reader.size) {
+        end -= pos;
+        base += m_Reader.size;
+    }
+    size_t writerPos = m_WriterShared.pos.load(std::memory_order_acquire);
+    size_t available = writerPos - base;
+    // Signed comparison (available can be negative)
+    return static_cast<ptrdiff_t>(available) < static_cast<ptrdiff_t>(end);
+}
+
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+void
+TRingBuffer<AtomicT, Alignment, WaitT>::
+FinishReadAt(size_t position)
+{
+    assert(static_cast<ptrdiff_t>(ReadPosition() - position) >= 0);
+    m_ReaderShared.pos.store(position, std::memory_order_release);
+}
+
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+void
+TRingBuffer<AtomicT, Alignment, WaitT>::
 GetBufferSpaceToWriteTo(size_t & pos, size_t & end)
 {
+    [[maybe_unused]] size_t const base = m_Writer.base;
     if (end > m_Writer.size) {
         end -= pos;
         pos = 0;
@@ -328,14 +843,53 @@ GetBufferSpaceToWriteTo(size_t & pos, size_t & end)
             m_Writer.end = std::min(available, m_Writer.size);
             break;
         }
+        if constexpr (std::is_same_v<AtomicT, PlainCursor>) {
+            m_Writer.base = base;
+            throw std::runtime_error("single threaded buffer is full");
+        }
+        WaitT::Wait(m_ReaderShared.pos, readerPos);
+    }
+}
+
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
+bool
+TRingBuffer<AtomicT, Alignment, WaitT>::
+TryGetBufferSpaceToWriteTo(size_t & pos, size_t & end, size_t spins)
+{
+    size_t base = m_Writer.base;
+    size_t newPos = pos;
+    size_t newEnd = end;
+    if (newEnd > m_Writer.size) {
+        newEnd -= newPos;
+        newPos = 0;
+        base += m_Writer.size;
+    }
+    for (size_t i = 0;; i++) {
+        size_t readerPos = m_ReaderShared.pos.load(std::memory_order_acquire);
+        size_t available = readerPos - base + m_Writer.size;
+        // Signed comparison (available can be negative)
+        if (static_cast<ptrdiff_t>(available) >=
+            static_cast<ptrdiff_t>(newEnd))
+        {
+            m_Writer.base = base;
+            m_Writer.end = std::min(available, m_Writer.size);
+            pos = newPos;
+            end = newEnd;
+            return true;
+        }
+        if (i == spins) {
+            return false;
+        }
+        WaitT::Wait(m_ReaderShared.pos, readerPos);
     }
 }
 
-template <typename AtomicT>
+template <typename AtomicT, std::size_t Alignment, typename WaitT>
 void
-TRingBuffer<AtomicT>::
+TRingBuffer<AtomicT, Alignment, WaitT>::
 GetBufferSpaceToReadFrom(size_t & pos, size_t & end)
 {
+    [[maybe_unused]] size_t const base = m_Reader.base;
     if (end > m_Reader.size) {
         end -= pos;
         pos = 0;
@@ -349,17 +903,52 @@ GetBufferSpaceToReadFrom(size_t & pos, size_t & end)
             m_Reader.end = std::min(available, m_Reader.size);
             break;
         }
+        if constexpr (std::is_same_v<AtomicT, PlainCursor>) {
+            m_Reader.base = base;
+            throw std::runtime_error("single threaded buffer is empty");
+        }
+        WaitT::Wait(m_WriterShared.pos, writerPos);
     }
 }
 
+namespace detail {
+// Writers that keep all of their state in the shared position, and so can
+// be used by more than one thread in turn, write through these.  The local
+// writer state is not used or updated.
+struct RingAccess
+{
+    template <typename AtomicT, std::size_t Alignment, typename WaitT>
+    static char * WriterBuffer(TRingBuffer<AtomicT, Alignment, WaitT> & ring)
+    {
+        return ring.m_Writer.buffer;
+    }
+
+    template <typename AtomicT, std::size_t Alignment, typename WaitT>
+    static AtomicT & WriterCursor(TRingBuffer<AtomicT, Alignment, WaitT> & ring)
+    {
+        return ring.m_WriterShared.pos;
+    }
+};
+} // namespace detail
+
 struct RingBuffer
 : TRingBuffer<std::atomic<size_t>>
 { };
 
+// First in, first out buffer for use by a single thread.  Reading from an
+// empty buffer, or writing to a full one, throws instead of waiting.  As
+// with the other buffers, writes are only readable after FinishWrite.
+struct SingleThreadedRingBuffer
+: TRingBuffer<PlainCursor, alignof(size_t)>
+{ };
+
 } // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
 
 namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::BusySpin;
+using rb::PlainCursor;
 using rb::RingBuffer;
+using rb::SingleThreadedRingBuffer;
 using rb::TRingBuffer;
 } // namespace DAUGAARD_RING_BUFFER_NAMESPACE
 
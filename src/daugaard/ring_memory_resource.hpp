@@ -0,0 +1,73 @@
+#ifndef DAUGAARD_RING_BUFFER_RING_MEMORY_RESOURCE_e05da4c5035c491583faf3b550a230db
+#define DAUGAARD_RING_BUFFER_RING_MEMORY_RESOURCE_e05da4c5035c491583faf3b550a230db
+
+// A std::pmr::memory_resource for memory that is freed in the order it was
+// allocated.  Allocation takes the next space in the ring, and deallocation
+// makes it available again, so both are as cheap as a write and a read.
+//
+// All allocations must come from the writer's thread, and all deallocations
+// from the reader's thread, which may be the same thread.  Memory must be
+// deallocated in allocation order, with the size and alignment it was
+// allocated with, and no allocation may be larger than the buffer.
+// Allocation waits while the buffer is full.
+
+#include "ring_buffer.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+#ifdef DAUGAARD_RING_BUFFER_DO_NOT_ALIGN
+    #error "TRingMemoryResource requires aligned writes"
+#endif
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+template <typename RingT>
+class TRingMemoryResource
+: public std::pmr::memory_resource
+{
+public:
+    explicit TRingMemoryResource(RingT & ring)
+    : m_Ring(ring)
+    { }
+
+private:
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        // The buffer itself is only aligned on a cache line.
+        if (alignment > DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) {
+            throw std::bad_alloc();
+        }
+        void * result = m_Ring.PrepareWrite(bytes, alignment);
+        m_Ring.FinishWrite();
+        return result;
+    }
+
+    void do_deallocate(
+        [[maybe_unused]] void * p,
+        std::size_t bytes,
+        std::size_t alignment) override
+    {
+        [[maybe_unused]] void * oldest = m_Ring.PrepareRead(bytes, alignment);
+        assert(oldest == p && "memory must be deallocated in FIFO order");
+        m_Ring.FinishRead();
+    }
+
+    bool do_is_equal(
+        std::pmr::memory_resource const & other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    RingT & m_Ring;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TRingMemoryResource;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_RING_MEMORY_RESOURCE_e05da4c5035c491583faf3b550a230db
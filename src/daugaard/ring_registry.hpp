@@ -0,0 +1,211 @@
+#ifndef DAUGAARD_RING_BUFFER_RING_REGISTRY_f0977716f18c4ffba80a5eb0ec388a39
+#define DAUGAARD_RING_BUFFER_RING_REGISTRY_f0977716f18c4ffba80a5eb0ec388a39
+
+// A directory of named rings in shared memory.  The process that creates the
+// rings lists each one with its place in one of a few large shared memory
+// segments.  Other processes map the registry and those segments once, then
+// attach to every ring they need by name, rather than opening and mapping
+// each ring on its own.
+//
+// The registry lives at the start of its own segment, followed by its
+// entries; RequiredSize gives the size.  Entries are only added, by one
+// process at a time, and each is visible to other processes once Add
+// returns.  An entry records the layout of the ring type it was added with,
+// and attaching with a different ring type throws.
+
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+template <typename AtomicT>
+class TRingRegistry
+{
+public:
+    inline static constexpr std::size_t maxNameLength = 47;
+
+    struct Entry
+    {
+        char name[maxNameLength + 1];
+        // Index of the segment holding the ring, chosen by the application.
+        std::uint32_t segment;
+        // Meaning chosen by the application, such as the owning process.
+        std::uint32_t role;
+        // Offsets of the ring object and its buffer within the segment.
+        std::uint64_t ringOffset;
+        std::uint64_t bufferOffset;
+        std::uint64_t capacity;
+        std::uint64_t layout;
+    };
+
+    // Identifies the version and layout of a ring type.
+    template <typename RingT>
+    static constexpr std::uint64_t LayoutOf()
+    {
+        return std::uint64_t(RingT::major) << 56 |
+            std::uint64_t(RingT::minor) << 48 |
+            std::uint64_t(sizeof(RingT)) << 16 | alignof(RingT);
+    }
+
+    // Size of the memory needed for the registry and its entries.
+    static constexpr std::size_t RequiredSize(std::size_t maxEntries)
+    {
+        return sizeof(TRingRegistry) + sizeof(Entry) * maxEntries;
+    }
+
+    // Initialize a registry at the start of memory, which must be at least
+    // RequiredSize(maxEntries) bytes.
+    static TRingRegistry & Initialize(void * memory, std::size_t maxEntries)
+    {
+        TRingRegistry * registry = new (memory) TRingRegistry;
+        registry->m_MaxEntries = maxEntries;
+        registry->m_Count.store(0, std::memory_order_relaxed);
+        registry->m_Magic.store(magic, std::memory_order_release);
+        return *registry;
+    }
+
+    // The registry at the start of memory.  Throws if there is none, or if
+    // it was made by a different version of this class.
+    static TRingRegistry & Attach(void * memory)
+    {
+        TRingRegistry * registry = static_cast<TRingRegistry *>(memory);
+        if (registry->m_Magic.load(std::memory_order_acquire) != magic) {
+            throw std::runtime_error("ring registry not found");
+        }
+        return *registry;
+    }
+
+    // Add a ring of type RingT.  Throws if the registry is full or the name
+    // is too long.
+    template <typename RingT>
+    void Add(
+        char const * name,
+        std::uint32_t segment,
+        std::uint32_t role,
+        std::uint64_t ringOffset,
+        std::uint64_t bufferOffset,
+        std::uint64_t capacity);
+
+    std::size_t Count() const
+    {
+        return m_Count.load(std::memory_order_acquire);
+    }
+
+    Entry const & At(std::size_t index) const
+    {
+        assert(index < Count());
+        return Entries()[index];
+    }
+
+    // The entry with the given name, or nullptr if there is none.
+    Entry const * Find(char const * name) const
+    {
+        std::size_t count = Count();
+        for (std::size_t i = 0; i < count; i++) {
+            if (std::strcmp(Entries()[i].name, name) == 0) {
+                return &Entries()[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // The ring of an entry, in the given segment mapping, with its writer
+    // or reader attached.  Throws if the ring is not of type RingT.
+    template <typename RingT>
+    static RingT & AttachWriter(Entry const & entry, void * segment)
+    {
+        RingT & ring = Locate<RingT>(entry, segment);
+        ring.ReattachWriter(static_cast<char *>(segment) + entry.bufferOffset);
+        return ring;
+    }
+
+    template <typename RingT>
+    static RingT & AttachReader(Entry const & entry, void * segment)
+    {
+        RingT & ring = Locate<RingT>(entry, segment);
+        ring.ReattachReader(static_cast<char *>(segment) + entry.bufferOffset);
+        return ring;
+    }
+
+private:
+    inline static constexpr std::uint64_t magic = 0x5247'4552'0001'0000;
+
+    template <typename RingT>
+    static RingT & Locate(Entry const & entry, void * segment)
+    {
+        RingT & ring = *reinterpret_cast<RingT *>(
+            static_cast<char *>(segment) + entry.ringOffset);
+        if (entry.layout != LayoutOf<RingT>() ||
+            entry.capacity != ring.Capacity())
+        {
+            throw std::runtime_error("ring layout does not match");
+        }
+        return ring;
+    }
+
+    Entry * Entries()
+    {
+        return reinterpret_cast<Entry *>(this + 1);
+    }
+
+    Entry const * Entries() const
+    {
+        return reinterpret_cast<Entry const *>(this + 1);
+    }
+
+    AtomicT m_Magic;
+    AtomicT m_Count;
+    std::size_t m_MaxEntries;
+};
+
+template <typename AtomicT>
+template <typename RingT>
+void
+TRingRegistry<AtomicT>::
+Add(char const * name,
+    std::uint32_t segment,
+    std::uint32_t role,
+    std::uint64_t ringOffset,
+    std::uint64_t bufferOffset,
+    std::uint64_t capacity)
+{
+    std::size_t count = m_Count.load(std::memory_order_relaxed);
+    if (count == m_MaxEntries) {
+        throw std::runtime_error("ring registry is full");
+    }
+    std::size_t length = std::strlen(name);
+    if (length > maxNameLength) {
+        throw std::runtime_error("ring name is too long");
+    }
+
+    Entry & entry = Entries()[count];
+    std::memset(entry.name, 0, sizeof(entry.name));
+    std::memcpy(entry.name, name, length);
+    entry.segment = segment;
+    entry.role = role;
+    entry.ringOffset = ringOffset;
+    entry.bufferOffset = bufferOffset;
+    entry.capacity = capacity;
+    entry.layout = LayoutOf<RingT>();
+    m_Count.store(count + 1, std::memory_order_release);
+}
+
+struct RingRegistry
+: TRingRegistry<std::atomic<size_t>>
+{ };
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::RingRegistry;
+using rb::TRingRegistry;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_RING_REGISTRY_f0977716f18c4ffba80a5eb0ec388a39
@@ -0,0 +1,283 @@
+#ifndef DAUGAARD_RING_BUFFER_SHARED_SLAB_0c76996deabe4dd99411e2f697b4514a
+#define DAUGAARD_RING_BUFFER_SHARED_SLAB_0c76996deabe4dd99411e2f697b4514a
+
+// A slab of fixed-size slots in shared memory, for payloads too large to
+// copy through a shared ring.  Large payloads are copied into runs of
+// contiguous slots, and the ring carries only their offset and size, which
+// mean the same thing in every process.  The reader frees the slots once it
+// has consumed the payload.
+//
+// As with TRingBuffer, the slab object and its memory live in shared memory,
+// and each process attaches its own pointer with ReattachWriter or
+// ReattachReader.  There is one writer, which allocates, and one reader,
+// which frees.  The memory starts with one AtomicT flag per slot, followed
+// by the slots; RequiredSize gives its size.
+
+#include "cpu.hpp"
+#include "ring_buffer.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+template <typename AtomicT>
+class TSharedSlab
+{
+public:
+    // Location of a payload, relative to the first slot.
+    struct Handle
+    {
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    // A payload read from a ring, either inline in the ring or in the slab.
+    struct Payload
+    {
+        void const * data;
+        std::size_t size;
+        Handle handle;
+    };
+
+    // Size of the memory needed for the flags and the slots.
+    static constexpr std::size_t RequiredSize(
+        std::size_t slotSize,
+        std::size_t slotCount)
+    {
+        return SlotsOffset(slotCount) + slotSize * slotCount;
+    }
+
+    // Initialize. Memory must be aligned on a cache line, and slotSize must
+    // be a multiple of the cache line size.
+    void Initialize(void * memory, std::size_t slotSize, std::size_t slotCount)
+    {
+        if (reinterpret_cast<std::uintptr_t>(memory) %
+                DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE !=
+            0)
+        {
+            throw std::runtime_error("memory is not aligned on cache line");
+        }
+        if (slotSize == 0 ||
+            slotSize % DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE != 0)
+        {
+            throw std::runtime_error(
+                "slot size must be a multiple of the cache line size");
+        }
+
+        m_Reader = m_Writer = LocalState();
+        m_Reader.slotSize = m_Writer.slotSize = slotSize;
+        m_Reader.slotCount = m_Writer.slotCount = slotCount;
+        ReattachReader(memory);
+        ReattachWriter(memory);
+        for (std::size_t i = 0; i < slotCount; ++i) {
+            Flags(m_Writer)[i].store(0, std::memory_order_seq_cst);
+        }
+    }
+
+    void ReattachReader(void * memory)
+    {
+        m_Reader.memory = static_cast<char *>(memory);
+    }
+
+    void ReattachWriter(void * memory)
+    {
+        m_Writer.memory = static_cast<char *>(memory);
+    }
+
+    // Writer: allocate slots for a payload, if enough contiguous slots are
+    // free.  Returns false, without waiting, if they are not.
+    bool TryAllocate(std::size_t size, Handle & handle);
+
+    // Writer: allocate slots for a payload, waiting for the reader to free
+    // enough contiguous slots.  The reader can only free the slots of
+    // payloads it has been handed, so every earlier payload must have been
+    // published, or this can wait forever.
+    Handle Allocate(std::size_t size);
+
+    // Writer: the memory of an allocated payload.
+    void * WriterData(Handle handle) const
+    {
+        return Slots(m_Writer) + handle.offset;
+    }
+
+    // Reader: the memory of an allocated payload.
+    void const * ReaderData(Handle handle) const
+    {
+        return Slots(m_Reader) + handle.offset;
+    }
+
+    // Reader: free the slots of a payload.
+    void Free(Handle handle);
+
+    // Writer: write a payload to a ring.  Payloads larger than threshold are
+    // copied into the slab, and only their handle is written to the ring.
+    // The caller publishes with FinishWrite as usual.  If the slab is full,
+    // everything written so far is published before waiting, so that the
+    // reader can free the slots of the payloads in it.
+    template <typename RingT>
+    void WritePayload(
+        RingT & ring,
+        void const * data,
+        std::size_t size,
+        std::size_t threshold);
+
+    // Reader: read a payload written with WritePayload.  The payload must be
+    // passed to Release once it has been consumed, and any inline data must
+    // not be used after FinishRead.
+    template <typename RingT>
+    Payload ReadPayload(RingT & ring);
+
+    // Reader: free the slots of a payload, if it used any.
+    void Release(Payload const & payload)
+    {
+        if (payload.handle.offset != inline_offset) {
+            Free(payload.handle);
+        }
+    }
+
+private:
+    // Offset of a payload stored inline in the ring.
+    static constexpr std::uint64_t inline_offset = ~std::uint64_t(0);
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) LocalState
+    {
+        char * memory;
+        std::size_t slotSize;
+        std::size_t slotCount;
+        std::size_t next;
+    };
+
+    static constexpr std::size_t SlotsOffset(std::size_t slotCount)
+    {
+        std::size_t const line = DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE;
+        return (slotCount * sizeof(AtomicT) + line - 1) & ~(line - 1);
+    }
+
+    static AtomicT * Flags(LocalState const & state)
+    {
+        return reinterpret_cast<AtomicT *>(state.memory);
+    }
+
+    static char * Slots(LocalState const & state)
+    {
+        return state.memory + SlotsOffset(state.slotCount);
+    }
+
+    LocalState m_Writer;
+    LocalState m_Reader;
+};
+
+template <typename AtomicT>
+bool
+TSharedSlab<AtomicT>::
+TryAllocate(std::size_t size, Handle & handle)
+{
+    std::size_t count = (size + m_Writer.slotSize - 1) / m_Writer.slotSize;
+    assert(count > 0 && count <= m_Writer.slotCount);
+    AtomicT * flags = Flags(m_Writer);
+    // Look at each slot at most once.
+    std::size_t scanned = 0;
+    while (scanned < m_Writer.slotCount) {
+        if (m_Writer.next + count > m_Writer.slotCount) {
+            scanned += m_Writer.slotCount - m_Writer.next;
+            m_Writer.next = 0;
+            continue;
+        }
+        std::size_t first = m_Writer.next;
+        std::size_t i = 0;
+        while (i < count &&
+               flags[first + i].load(std::memory_order_acquire) == 0)
+        {
+            ++i;
+        }
+        if (i == count) {
+            for (i = 0; i < count; ++i) {
+                flags[first + i].store(1, std::memory_order_relaxed);
+            }
+            m_Writer.next = first + count;
+            handle = Handle{first * m_Writer.slotSize, size};
+            return true;
+        }
+        // Slot first + i is still in use, so no run can start before it.
+        m_Writer.next = first + i + 1;
+        scanned += i + 1;
+    }
+    return false;
+}
+
+template <typename AtomicT>
+auto
+TSharedSlab<AtomicT>::
+Allocate(std::size_t size)
+-> Handle
+{
+    Handle handle;
+    while (not TryAllocate(size, handle)) {
+        detail::cpu_relax();
+    }
+    return handle;
+}
+
+template <typename AtomicT>
+void
+TSharedSlab<AtomicT>::
+Free(Handle handle)
+{
+    std::size_t first = handle.offset / m_Reader.slotSize;
+    std::size_t count =
+        (handle.size + m_Reader.slotSize - 1) / m_Reader.slotSize;
+    AtomicT * flags = Flags(m_Reader);
+    for (std::size_t i = 0; i < count; ++i) {
+        flags[first + i].store(0, std::memory_order_release);
+    }
+}
+
+template <typename AtomicT>
+template <typename RingT>
+void
+TSharedSlab<AtomicT>::
+WritePayload(
+    RingT & ring,
+    void const * data,
+    std::size_t size,
+    std::size_t threshold)
+{
+    if (size <= threshold) {
+        ring.Write(Handle{inline_offset, size});
+        std::memcpy(ring.PrepareWrite(size, 1), data, size);
+    } else {
+        Handle handle;
+        if (not TryAllocate(size, handle)) {
+            ring.FinishWrite();
+            handle = Allocate(size);
+        }
+        std::memcpy(WriterData(handle), data, size);
+        ring.Write(handle);
+    }
+}
+
+template <typename AtomicT>
+template <typename RingT>
+auto
+TSharedSlab<AtomicT>::
+ReadPayload(RingT & ring)
+-> Payload
+{
+    Handle handle = ring.template Read<Handle>();
+    if (handle.offset == inline_offset) {
+        return Payload{ring.PrepareRead(handle.size, 1), handle.size, handle};
+    }
+    return Payload{ReaderData(handle), handle.size, handle};
+}
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TSharedSlab;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_SHARED_SLAB_0c76996deabe4dd99411e2f697b4514a
@@ -0,0 +1,145 @@
+#ifndef DAUGAARD_RING_BUFFER_SLEEPING_READER_3ca2fc9aa3184b9399b58140b3b18168
+#define DAUGAARD_RING_BUFFER_SLEEPING_READER_3ca2fc9aa3184b9399b58140b3b18168
+
+// Lets the reader sleep while the buffer is empty, at almost no cost to the
+// writer.  Before it sleeps, the reader sets a flag and then checks the
+// writer's position again.  Normally the writer would need a full fence
+// between publishing and checking that flag, on every publish.  Here the
+// reader runs membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) instead, which
+// forces that fence on every running thread of the process, only when the
+// reader is about to sleep.  The writer pays for a plain load of the flag.
+//
+// On Linux the reader sleeps on a futex.  Elsewhere both sides use a
+// seq_cst fence, and the reader yields instead of sleeping.  The writer and
+// reader must be in the same process.
+
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__linux__)
+    #include <linux/futex.h>
+    #include <linux/membarrier.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#else
+    #include <thread>
+#endif
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+template <typename RingT>
+class TSleepingReader
+{
+public:
+    // Throws if the kernel does not support expedited private membarrier.
+    explicit TSleepingReader(RingT & ring)
+    : m_Ring(ring)
+    {
+        m_Sleeping.flag.store(0, std::memory_order_relaxed);
+#if defined(__linux__)
+        if (syscall(
+                __NR_membarrier,
+                MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED,
+                0,
+                0) != 0)
+        {
+            throw std::runtime_error("membarrier is not supported");
+        }
+#endif
+    }
+
+    TSleepingReader(TSleepingReader const &) = delete;
+    TSleepingReader & operator = (TSleepingReader const &) = delete;
+
+    // Writer: publish written data, and wake the reader if it is asleep.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishWrite()
+    {
+        m_Ring.FinishWrite();
+#if defined(__linux__)
+        // Only the compiler needs to keep the load after the store; the
+        // reader's membarrier provides the hardware fence.
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#else
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+        if (m_Sleeping.flag.load(std::memory_order_relaxed) != 0) {
+            Wake();
+        }
+    }
+
+    // Reader: sleep until the writer has published data that has not been
+    // read yet.
+    void WaitForData()
+    {
+        while (Empty()) {
+            Sleep();
+        }
+    }
+
+private:
+    bool Empty() const
+    {
+        return m_Ring.PublishedWritePosition() == m_Ring.ReadPosition();
+    }
+
+    void Sleep()
+    {
+        m_Sleeping.flag.store(1, std::memory_order_relaxed);
+#if defined(__linux__)
+        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+        if (Empty()) {
+            // Returns at once if the writer has already cleared the flag.
+            syscall(
+                SYS_futex,
+                &m_Sleeping.flag,
+                FUTEX_WAIT_PRIVATE,
+                1,
+                nullptr,
+                nullptr,
+                0);
+        }
+#else
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (Empty()) {
+            std::this_thread::yield();
+        }
+#endif
+        m_Sleeping.flag.store(0, std::memory_order_relaxed);
+    }
+
+    void Wake()
+    {
+        m_Sleeping.flag.store(0, std::memory_order_relaxed);
+#if defined(__linux__)
+        syscall(
+            SYS_futex,
+            &m_Sleeping.flag,
+            FUTEX_WAKE_PRIVATE,
+            1,
+            nullptr,
+            nullptr,
+            0);
+#endif
+    }
+
+    RingT & m_Ring;
+
+    // Set by the reader while it is, or is about to be, asleep.
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) SleepState
+    {
+        std::atomic<std::uint32_t> flag;
+    };
+
+    SleepState m_Sleeping;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TSleepingReader;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_SLEEPING_READER_3ca2fc9aa3184b9399b58140b3b18168
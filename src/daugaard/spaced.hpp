@@ -0,0 +1,150 @@
+#ifndef DAUGAARD_RING_BUFFER_SPACED_9888f767ee624c109a340fa158a6965c
+#define DAUGAARD_RING_BUFFER_SPACED_9888f767ee624c109a340fa158a6965c
+
+// Records that start on a fresh cache line while the reader is close behind
+// the writer.  When the ring is nearly empty, the reader reads a record from
+// the same line that the writer is filling with the next one, and the line
+// moves between their caches on every message.  Starting the next record on
+// its own line avoids that.  While the reader is further behind, records
+// are packed together as usual.
+//
+// Each record is a SpacedHeader followed by its payload.  The header holds
+// the size and alignment of the payload, and the alignment of the next
+// header, which the writer chooses when it publishes.
+//
+// Loading the reader's position on every publish would itself move a line
+// that the reader writes on every FinishRead, so the writer only samples it
+// once every sampleInterval publishes, and keeps spacing, or packing, until
+// the next sample.  This costs eight bytes of header per record, a decrement
+// per publish, and up to a cache line of padding after each publish while
+// the reader is close.
+
+#include "ring_buffer.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+struct SpacedHeader
+{
+    std::uint32_t size;
+    std::uint16_t alignment;
+    // Alignment of the header of the next record.
+    std::uint16_t next;
+};
+
+template <typename RingT>
+class TSpacedWriter
+{
+public:
+    // Records are spaced while the reader is less than close bytes behind,
+    // as sampled once every sampleInterval publishes.
+    explicit TSpacedWriter(
+        RingT & ring,
+        std::size_t close = 2 * DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE,
+        std::uint32_t sampleInterval = 16)
+    : m_Ring(ring)
+    , m_Close(close)
+    , m_SampleInterval(sampleInterval)
+    {
+        assert(sampleInterval > 0);
+    }
+
+    TSpacedWriter(TSpacedWriter const &) = delete;
+    TSpacedWriter & operator = (TSpacedWriter const &) = delete;
+
+    // Allocate space for a record's payload.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareWrite(
+        size_t size,
+        size_t alignment)
+    {
+        assert(size <= UINT32_MAX);
+        assert(alignment <= UINT16_MAX);
+        m_Header = static_cast<SpacedHeader *>(
+            m_Ring.PrepareWrite(sizeof(SpacedHeader), m_Next));
+        m_Header->size = static_cast<std::uint32_t>(size);
+        m_Header->alignment = static_cast<std::uint16_t>(alignment);
+        m_Header->next = m_Next = alignof(SpacedHeader);
+        return m_Ring.PrepareWrite(size, alignment);
+    }
+
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void Write(T const & value)
+    {
+        void * dest = PrepareWrite(sizeof(T), alignof(T));
+        new (dest) T(value);
+    }
+
+    // Publish written records.  If the reader was close behind at the last
+    // sample, the next record starts on a fresh cache line.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishWrite()
+    {
+        if (--m_Countdown == 0) {
+            m_Countdown = m_SampleInterval;
+            m_Spacing =
+                m_Ring.WritePosition() - m_Ring.PublishedReadPosition() <
+                m_Close;
+        }
+        if (m_Header != nullptr && m_Spacing) {
+            m_Header->next = m_Next = DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE;
+        }
+        m_Header = nullptr;
+        m_Ring.FinishWrite();
+    }
+
+private:
+    RingT & m_Ring;
+    std::size_t m_Close;
+    std::uint32_t m_SampleInterval;
+    std::uint32_t m_Countdown = 1;
+    bool m_Spacing = false;
+    // Header of the last record written, until it is published.
+    SpacedHeader * m_Header = nullptr;
+    std::size_t m_Next = alignof(SpacedHeader);
+};
+
+template <typename RingT>
+class TSpacedReader
+{
+public:
+    explicit TSpacedReader(RingT & ring)
+    : m_Ring(ring)
+    { }
+
+    TSpacedReader(TSpacedReader const &) = delete;
+    TSpacedReader & operator = (TSpacedReader const &) = delete;
+
+    // Read the next record, and return its payload and size.  Call
+    // FinishRead on the ring as usual.
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void const * Read(std::size_t & size)
+    {
+        SpacedHeader const & header = *static_cast<SpacedHeader const *>(
+            m_Ring.PrepareRead(sizeof(SpacedHeader), m_Next));
+        m_Next = header.next;
+        size = header.size;
+        return m_Ring.PrepareRead(header.size, header.alignment);
+    }
+
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE const T & Read()
+    {
+        std::size_t size;
+        return *static_cast<T const *>(Read(size));
+    }
+
+private:
+    RingT & m_Ring;
+    std::size_t m_Next = alignof(SpacedHeader);
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::SpacedHeader;
+using rb::TSpacedReader;
+using rb::TSpacedWriter;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_SPACED_9888f767ee624c109a340fa158a6965c
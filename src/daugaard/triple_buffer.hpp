@@ -0,0 +1,103 @@
+#ifndef DAUGAARD_RING_BUFFER_TRIPLE_BUFFER_70bb22e5e56c4f12be65d244d2524d89
+#define DAUGAARD_RING_BUFFER_TRIPLE_BUFFER_70bb22e5e56c4f12be65d244d2524d89
+
+// Passes the latest version of a large value from one writer to one reader,
+// for state where only the newest complete version matters.  There are
+// three copies of the value.  The writer fills one, the reader reads
+// another, and the third is the most recently published.  Publishing and
+// picking up a new version are each one atomic exchange of the index of
+// the middle copy, so neither side ever waits or copies.  Versions that the
+// reader does not pick up in time are overwritten.
+
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+template <typename T>
+class TTripleBuffer
+{
+public:
+    TTripleBuffer()
+    {
+        m_Writer.index = 0;
+        m_Shared.index.store(1, std::memory_order_relaxed);
+        m_Reader.index = 2;
+    }
+
+    TTripleBuffer(TTripleBuffer const &) = delete;
+    TTripleBuffer & operator = (TTripleBuffer const &) = delete;
+
+    // Writer: the copy to fill in.  It holds an older version, or a
+    // value-initialized T.
+    T & WriteBuffer() { return m_Slots[m_Writer.index].value; }
+
+    // Writer: publish the copy returned by WriteBuffer, and take another.
+    void Publish()
+    {
+        std::uint32_t previous = m_Shared.index.exchange(
+            m_Writer.index | fresh,
+            std::memory_order_acq_rel);
+        m_Writer.index = previous & index_mask;
+    }
+
+    // Reader: pick up the latest published copy, if there is a new one.
+    // Returns true if there was.
+    bool Update()
+    {
+        if ((m_Shared.index.load(std::memory_order_relaxed) & fresh) == 0) {
+            return false;
+        }
+        std::uint32_t previous = m_Shared.index.exchange(
+            m_Reader.index,
+            std::memory_order_acq_rel);
+        m_Reader.index = previous & index_mask;
+        return true;
+    }
+
+    // Reader: the copy picked up by the last Update.  It stays unchanged
+    // until the next Update.
+    T const & ReadBuffer() const { return m_Slots[m_Reader.index].value; }
+
+    // Reader: Update, then ReadBuffer.
+    T const & Read()
+    {
+        Update();
+        return ReadBuffer();
+    }
+
+private:
+    // Set in the shared index when the copy it names has not been read.
+    static constexpr std::uint32_t fresh = 4;
+    static constexpr std::uint32_t index_mask = 3;
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) Slot
+    {
+        T value{};
+    };
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) LocalState
+    {
+        std::uint32_t index;
+    };
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) SharedState
+    {
+        std::atomic<std::uint32_t> index;
+    };
+
+    LocalState m_Writer;
+    LocalState m_Reader;
+    SharedState m_Shared;
+    Slot m_Slots[3];
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TTripleBuffer;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_TRIPLE_BUFFER_70bb22e5e56c4f12be65d244d2524d89
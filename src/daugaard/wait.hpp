@@ -0,0 +1,131 @@
+#ifndef DAUGAARD_RING_BUFFER_WAIT_8a9d03d7cd1843028e99039a61671cc2
+#define DAUGAARD_RING_BUFFER_WAIT_8a9d03d7cd1843028e99039a61671cc2
+
+// Wait strategies for the WaitT parameter of TRingBuffer.
+//
+// PauseSpin spins with a pause hint, which frees execution resources for
+// the other hyperthread on the core.
+//
+// MonitorWait arms the hardware monitor on the cache line of the other
+// side's position, and sleeps in a low-power state until that line is
+// written, or until TimeoutCycles cycles have passed.  It uses UMONITOR and
+// UMWAIT where the processor has WAITPKG (Intel), MONITORX and MWAITX where
+// it has those (AMD), and falls back to PauseSpin otherwise.  Support is
+// detected once, at run time.
+
+#include "cpu.hpp"
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #include <cpuid.h>
+    #include <immintrin.h>
+    #define DAUGAARD_RING_BUFFER_HAS_MONITOR_WAIT 1
+#endif
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+struct PauseSpin
+{
+    template <typename AtomicT>
+    static void Wait(AtomicT const &, size_t)
+    {
+        detail::cpu_relax();
+    }
+};
+
+namespace detail {
+#ifdef DAUGAARD_RING_BUFFER_HAS_MONITOR_WAIT
+enum class MonitorKind
+{
+    none,
+    umwait,
+    mwaitx
+};
+
+inline MonitorKind
+detect_monitor_kind()
+{
+    unsigned a, b, c, d;
+    if (__get_cpuid_count(7, 0, &a, &b, &c, &d) && (c & (1u << 5))) {
+        return MonitorKind::umwait;
+    }
+    if (__get_cpuid(0x80000001, &a, &b, &c, &d) && (c & (1u << 29))) {
+        return MonitorKind::mwaitx;
+    }
+    return MonitorKind::none;
+}
+
+inline MonitorKind
+monitor_kind()
+{
+    static MonitorKind const kind = detect_monitor_kind();
+    return kind;
+}
+
+// The position is loaded again after the monitor is armed, so a write that
+// happened just before can not be missed.
+template <typename AtomicT>
+__attribute__((target("waitpkg"))) void
+umwait_for_change(AtomicT const & pos, size_t observed, std::uint64_t cycles)
+{
+    _umonitor(const_cast<AtomicT *>(&pos));
+    if (pos.load(std::memory_order_relaxed) == observed) {
+        // Control 1 selects C0.1, which wakes faster than C0.2.
+        _umwait(1, __rdtsc() + cycles);
+    }
+}
+
+template <typename AtomicT>
+__attribute__((target("mwaitx"))) void
+mwaitx_for_change(AtomicT const & pos, size_t observed, std::uint32_t cycles)
+{
+    _mm_monitorx(const_cast<AtomicT *>(&pos), 0, 0);
+    if (pos.load(std::memory_order_relaxed) == observed) {
+        // Extension 2 enables the timeout.
+        _mm_mwaitx(2, 0, cycles);
+    }
+}
+#endif
+} // namespace detail
+
+template <std::uint32_t TimeoutCycles = 100000>
+struct MonitorWait
+{
+    template <typename AtomicT>
+    static void Wait(AtomicT const & pos, size_t observed)
+    {
+#ifdef DAUGAARD_RING_BUFFER_HAS_MONITOR_WAIT
+        switch (detail::monitor_kind()) {
+        case detail::MonitorKind::umwait:
+            detail::umwait_for_change(pos, observed, TimeoutCycles);
+            return;
+        case detail::MonitorKind::mwaitx:
+            detail::mwaitx_for_change(pos, observed, TimeoutCycles);
+            return;
+        case detail::MonitorKind::none:
+            break;
+        }
+#endif
+        PauseSpin::Wait(pos, observed);
+    }
+};
+
+struct LowPowerRingBuffer
+: TRingBuffer<
+      std::atomic<size_t>,
+      DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE,
+      MonitorWait<>>
+{ };
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::LowPowerRingBuffer;
+using rb::MonitorWait;
+using rb::PauseSpin;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_WAIT_8a9d03d7cd1843028e99039a61671cc2
@@ -0,0 +1,210 @@
+#ifndef DAUGAARD_RING_BUFFER_WATERMARKS_efe266bac2e1413f985e21807fa8997e
+#define DAUGAARD_RING_BUFFER_WATERMARKS_efe266bac2e1413f985e21807fa8997e
+
+// Flow control callbacks for a ring.  When the unread data in the ring
+// reaches the high watermark, the writer calls onHigh, and when it has since
+// fallen to the low watermark, the reader calls onLow.  The gap between the
+// two keeps the callbacks from firing on every message while the ring hovers
+// around one level.  A writer that reads from a socket can stop reading in
+// onHigh, and be told to start again from onLow.
+//
+// The level is checked against thresholds that each side keeps for itself, so
+// the common path costs a comparison, and a decrement on the reader.  The
+// writer remembers the reader's position from its last check, and checks again
+// once it has written high bytes past it.  Until then the ring can not hold
+// high bytes, so no crossing is missed.  While the level stays at or above
+// high, each write checks again.  The reader notices that onHigh has been
+// called within checkInterval calls to FinishRead, and then remembers the
+// writer's position, and checks again once it has read to within low bytes of
+// it.
+//
+// onHigh and onLow are called on the writer and reader threads, and always
+// in turn: onLow is not called until onHigh has returned, and the other way
+// around.  Both are passed the level they saw.
+
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb {
+
+struct WatermarkConfig
+{
+    // Bytes of unread data at which onHigh is called.
+    std::size_t high;
+
+    // Bytes of unread data at which onLow is called, after onHigh.
+    std::size_t low;
+
+    // Calls to FinishRead between checks of the level by the reader.
+    std::uint32_t checkInterval = 64;
+};
+
+template <typename RingT, typename OnHighT, typename OnLowT>
+class TWatermarkedRing
+{
+public:
+    // Throws unless low < high <= the ring's capacity, and checkInterval is
+    // not zero.
+    TWatermarkedRing(
+        RingT & ring,
+        WatermarkConfig const & config,
+        OnHighT onHigh,
+        OnLowT onLow)
+    : m_Ring(ring)
+    , m_Writer{
+          config.high,
+          ring.PublishedReadPosition() + config.high,
+          std::move(onHigh)}
+    , m_Reader{
+          config.low,
+          never,
+          config.checkInterval,
+          config.checkInterval,
+          std::move(onLow)}
+    {
+        if (config.low >= config.high || config.high > ring.Capacity() ||
+            config.checkInterval == 0)
+        {
+            throw std::runtime_error("invalid watermarks");
+        }
+        m_Shared.high.store(false, std::memory_order_relaxed);
+    }
+
+    TWatermarkedRing(TWatermarkedRing const &) = delete;
+    TWatermarkedRing & operator = (TWatermarkedRing const &) = delete;
+
+    RingT & Ring() { return m_Ring; }
+
+    // Any thread: true between onHigh and onLow.
+    bool IsHigh() const
+    {
+        return m_Shared.high.load(std::memory_order_acquire);
+    }
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareWrite(
+        size_t size,
+        size_t alignment)
+    {
+        void * dest = m_Ring.PrepareWrite(size, alignment);
+        if (m_Ring.WritePosition() >= m_Writer.threshold) {
+            CheckHigh();
+        }
+        return dest;
+    }
+
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void Write(T const & value)
+    {
+        void * dest = PrepareWrite(sizeof(T), alignof(T));
+        new (dest) T(value);
+    }
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishWrite()
+    {
+        m_Ring.FinishWrite();
+    }
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void * PrepareRead(
+        size_t size,
+        size_t alignment)
+    {
+        return m_Ring.PrepareRead(size, alignment);
+    }
+
+    template <typename T>
+    DAUGAARD_RING_BUFFER_FORCE_INLINE const T & Read()
+    {
+        return *static_cast<T const *>(PrepareRead(sizeof(T), alignof(T)));
+    }
+
+    DAUGAARD_RING_BUFFER_FORCE_INLINE void FinishRead()
+    {
+        m_Ring.FinishRead();
+        if (--m_Reader.countdown == 0 ||
+            m_Ring.ReadPosition() >= m_Reader.threshold)
+        {
+            m_Reader.countdown = m_Reader.checkInterval;
+            CheckLow();
+        }
+    }
+
+private:
+    static constexpr std::size_t never = ~std::size_t(0);
+
+    // Only the writer sets the flag, and only the reader clears it.  Each
+    // sets it after its callback returns, so the callbacks never overlap.
+    void CheckHigh()
+    {
+        std::size_t readerPos = m_Ring.PublishedReadPosition();
+        m_Writer.threshold = readerPos + m_Writer.high;
+        std::size_t level = m_Ring.WritePosition() - readerPos;
+        if (level >= m_Writer.high &&
+            not m_Shared.high.load(std::memory_order_acquire))
+        {
+            m_Writer.onHigh(level);
+            m_Shared.high.store(true, std::memory_order_release);
+        }
+    }
+
+    void CheckLow()
+    {
+        if (not m_Shared.high.load(std::memory_order_acquire)) {
+            m_Reader.threshold = never;
+            return;
+        }
+        std::size_t writerPos = m_Ring.PublishedWritePosition();
+        std::size_t level = writerPos - m_Ring.ReadPosition();
+        if (level <= m_Reader.low) {
+            m_Reader.threshold = never;
+            m_Reader.onLow(level);
+            m_Shared.high.store(false, std::memory_order_release);
+        } else {
+            m_Reader.threshold = writerPos - m_Reader.low;
+        }
+    }
+
+    RingT & m_Ring;
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) WriterState
+    {
+        std::size_t high;
+        // Write position at which to check the level again.
+        std::size_t threshold;
+        OnHighT onHigh;
+    };
+
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) ReaderState
+    {
+        std::size_t low;
+        // Read position at which to check the level again.
+        std::size_t threshold;
+        std::uint32_t checkInterval;
+        std::uint32_t countdown;
+        OnLowT onLow;
+    };
+
+    // Written by the writer and the reader in turn.
+    struct alignas(DAUGAARD_RING_BUFFER_CACHE_LINE_SIZE) SharedState
+    {
+        std::atomic<bool> high;
+    };
+
+    WriterState m_Writer;
+    ReaderState m_Reader;
+    SharedState m_Shared;
+};
+
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE::rb
+
+namespace DAUGAARD_RING_BUFFER_NAMESPACE {
+using rb::TWatermarkedRing;
+using rb::WatermarkConfig;
+} // namespace DAUGAARD_RING_BUFFER_NAMESPACE
+
+#endif // DAUGAARD_RING_BUFFER_WATERMARKS_efe266bac2e1413f985e21807fa8997e
@@ -0,0 +1,247 @@
+// ringstat: watch a ring in shared memory without disturbing it.
+//
+// The shared memory object is opened and mapped read only, and only the
+// writer's and reader's published positions are loaded, so running ringstat
+// can not change the ring or its cursors.  Each sample prints the bytes per
+// second written and read, how full the ring is, how far the reader lags
+// behind the writer, and how often the writer wraps around.
+//
+// Usage:
+//   ringstat [-i ms] [-n count] [-c] <shm-name> <ring-offset>
+//   ringstat [-i ms] [-n count] -r <registry-shm> <ring-name> <segment-shm>...
+//
+// The ring is either at a byte offset in a shared memory object, or found
+// by name in a TRingRegistry, whose segment indices select among the given
+// segment names.  -c reads the ring as a CompactRingBuffer rather than a
+// RingBuffer; with a registry, the type is taken from the entry.
+
+#include <daugaard/ring_arena.hpp>
+#include <daugaard/ring_buffer.hpp>
+#include <daugaard/ring_registry.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+using DAUGAARD_RING_BUFFER_NAMESPACE::CompactRingBuffer;
+using DAUGAARD_RING_BUFFER_NAMESPACE::RingBuffer;
+using DAUGAARD_RING_BUFFER_NAMESPACE::RingRegistry;
+
+struct Options
+{
+    int intervalMs = 1000;
+    long count = 0;
+    bool compact = false;
+    char const * registry = nullptr;
+};
+
+// A read-only mapping of a whole shared memory object.
+class Mapping
+{
+public:
+    explicit Mapping(char const * name)
+    {
+        int fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("can not open ") + name);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error(std::string("can not stat ") + name);
+        }
+        m_Size = static_cast<std::size_t>(st.st_size);
+        m_Data = mmap(nullptr, m_Size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (m_Data == MAP_FAILED) {
+            throw std::runtime_error(std::string("can not map ") + name);
+        }
+    }
+
+    ~Mapping() { munmap(m_Data, m_Size); }
+
+    std::size_t Size() const { return m_Size; }
+
+    Mapping(Mapping const &) = delete;
+    Mapping & operator = (Mapping const &) = delete;
+
+    // The object of type T at offset, which must lie inside the mapping.
+    template <typename T>
+    T const & At(std::size_t offset) const
+    {
+        if (offset > m_Size || m_Size - offset < sizeof(T)) {
+            throw std::runtime_error("offset is outside the mapping");
+        }
+        return *reinterpret_cast<T const *>(
+            static_cast<char const *>(m_Data) + offset);
+    }
+
+private:
+    void * m_Data;
+    std::size_t m_Size;
+};
+
+template <typename RingT>
+void
+Monitor(RingT const & ring, Options const & options)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::size_t const capacity = ring.Capacity();
+    std::printf(
+        "%12s %12s %9s %12s %10s\n",
+        "write B/s",
+        "read B/s",
+        "occupancy",
+        "lag B",
+        "wraps/s");
+
+    std::size_t lastWrite = ring.PublishedWritePosition();
+    std::size_t lastRead = ring.PublishedReadPosition();
+    Clock::time_point lastTime = Clock::now();
+    for (long i = 0; options.count == 0 || i < options.count; i++) {
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(options.intervalMs));
+
+        // Load the reader's position first, so it is never ahead of the
+        // writer's.
+        std::size_t read = ring.PublishedReadPosition();
+        std::size_t write = ring.PublishedWritePosition();
+        Clock::time_point now = Clock::now();
+        double seconds = std::chrono::duration<double>(now - lastTime).count();
+
+        std::size_t lag = write - read;
+        std::printf(
+            "%12.0f %12.0f %8.1f%% %12zu %10.1f\n",
+            double(write - lastWrite) / seconds,
+            double(read - lastRead) / seconds,
+            100.0 * double(lag) / double(capacity),
+            lag,
+            double(write / capacity - lastWrite / capacity) / seconds);
+        std::fflush(stdout);
+
+        lastWrite = write;
+        lastRead = read;
+        lastTime = now;
+    }
+}
+
+int
+Usage()
+{
+    std::fprintf(
+        stderr,
+        "usage: ringstat [-i ms] [-n count] [-c] <shm-name> <ring-offset>\n"
+        "       ringstat [-i ms] [-n count] -r <registry-shm> <ring-name> "
+        "<segment-shm>...\n");
+    return 2;
+}
+
+int
+MonitorRegistered(int argc, char ** argv, Options const & options)
+{
+    using Registry = RingRegistry;
+
+    if (argc < 2) {
+        return Usage();
+    }
+    Mapping registryMapping(options.registry);
+    // Attach and Find only load from the registry.
+    auto & registry = Registry::Attach(const_cast<Registry *>(
+        &registryMapping.At<Registry>(0)));
+    // The count comes from the mapping, so check it before walking the
+    // entries.
+    std::size_t const maxEntries =
+        (registryMapping.Size() - sizeof(Registry)) / sizeof(Registry::Entry);
+    if (registry.Count() > maxEntries ||
+        Registry::RequiredSize(registry.Count()) > registryMapping.Size())
+    {
+        throw std::runtime_error("registry is larger than its mapping");
+    }
+    Registry::Entry const * entry = registry.Find(argv[0]);
+    if (entry == nullptr) {
+        throw std::runtime_error(std::string("no ring named ") + argv[0]);
+    }
+    if (entry->segment >= static_cast<std::uint32_t>(argc - 1)) {
+        throw std::runtime_error("segment of the ring was not given");
+    }
+
+    Mapping segment(argv[1 + entry->segment]);
+    if (entry->layout == Registry::LayoutOf<RingBuffer>()) {
+        Monitor(segment.At<RingBuffer>(entry->ringOffset), options);
+    } else if (entry->layout == Registry::LayoutOf<CompactRingBuffer>()) {
+        Monitor(segment.At<CompactRingBuffer>(entry->ringOffset), options);
+    } else {
+        throw std::runtime_error("unknown ring layout");
+    }
+    return 0;
+}
+
+int
+Run(int argc, char ** argv)
+{
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:cr:")) != -1) {
+        switch (opt) {
+        case 'i':
+            options.intervalMs = std::atoi(optarg);
+            break;
+        case 'n':
+            options.count = std::atol(optarg);
+            break;
+        case 'c':
+            options.compact = true;
+            break;
+        case 'r':
+            options.registry = optarg;
+            break;
+        default:
+            return Usage();
+        }
+    }
+    if (options.intervalMs <= 0) {
+        return Usage();
+    }
+    argc -= optind;
+    argv += optind;
+
+    if (options.registry != nullptr) {
+        return MonitorRegistered(argc, argv, options);
+    }
+    if (argc != 2) {
+        return Usage();
+    }
+    Mapping segment(argv[0]);
+    std::size_t offset = std::strtoull(argv[1], nullptr, 0);
+    if (options.compact) {
+        Monitor(segment.At<CompactRingBuffer>(offset), options);
+    } else {
+        Monitor(segment.At<RingBuffer>(offset), options);
+    }
+    return 0;
+}
+
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+    try {
+        return Run(argc, argv);
+    } catch (std::exception const & e) {
+        std::fprintf(stderr, "ringstat: %s\n", e.what());
+        return 1;
+    }
+}